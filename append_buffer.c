@@ -1,17 +1,45 @@
 #include "append_buffer.h"
+#include "utils.h"
 
-void abAppend(struct abuf *ab, const char *s, int len){
-    char *new = realloc(ab->b, ab->len + len);
-    
-    if (new == NULL){
+// grows the capacity geometrically so a buffer that is reset and refilled stops allocating
+static void abGrow(struct abuf *ab, int len){
+    if (ab->len + len <= ab->cap){
         return;
     }
 
-    memcpy(&new[ab->len], s, len);
+    int cap = ab->cap ? ab->cap : ABUF_MIN_CAP;
+    while (cap < ab->len + len){
+        cap *= 2;
+    }
+
+    char *new = realloc(ab->b, cap);
+    if (new == NULL){
+        die("abAppend");
+    }
     ab->b = new;
+    ab->cap = cap;
+}
+
+void abAppend(struct abuf *ab, const char *s, int len){
+    abGrow(ab, len);
+    memcpy(&ab->b[ab->len], s, len);
     ab->len += len;
 }
 
+// hands out len bytes at the end of the buffer for the caller to fill in place
+char *abReserve(struct abuf *ab, int len){
+    abGrow(ab, len);
+    char *s = &ab->b[ab->len];
+    ab->len += len;
+    return s;
+}
+
+void abReset(struct abuf *ab){
+    ab->len = 0;
+}
+
 void abFree(struct abuf *ab){
     free(ab->b);
+    ab->b = NULL;
+    ab->len = ab->cap = 0;
 }
@@ -1,7 +1,8 @@
 #ifndef KILO_AB_BUFFER_H
 #define KILO_AB_BUFFER_H
 
-#define ABUF_INIT {NULL, 0}
+#define ABUF_INIT {NULL, 0, 0}
+#define ABUF_MIN_CAP 4096
 
 #include <stdlib.h>
 #include <string.h>
@@ -9,9 +10,12 @@
 struct abuf {
   char *b;
   int len;
+  int cap;
 };
 
 void abAppend(struct abuf *ab, const char *s, int len);
+char *abReserve(struct abuf *ab, int len);
+void abReset(struct abuf *ab);
 void abFree(struct abuf *ab);
 
 #endif
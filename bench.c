@@ -0,0 +1,206 @@
+/*** includes ***/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "editor_config.h"
+#include "screen.h"
+#include "text_highlighting.h"
+#include "utils.h"
+
+/*** defines ***/
+
+#define BENCH_ROWS 24
+#define BENCH_COLS 80
+#define BENCH_LINES 200000
+
+typedef struct benchOp{
+    const char *name;
+    const char *setup;
+    const char *keys;
+    int times;
+    const char *teardown;
+}benchOp;
+
+// every script leaves the editor in normal mode so the next one starts from a known state
+static benchOp bench_ops[] = {
+    {"move down",       NULL,  "j",          3000, NULL},
+    {"move up",         NULL,  "k",          1000, NULL},
+    {"page down",       NULL,  "\x1b[6~",    500,  NULL},
+    {"page up",         NULL,  "\x1b[5~",    200,  NULL},
+    {"move right",      NULL,  "l",          500,  NULL},
+    {"insert char",     "i",   "a",          3000, "\x1b"},
+    {"insert newline",  "i",   "\r",         1000, "\x1b"},
+    {"backspace",       "i",   "\x7f",       1000, "\x1b"},
+    {"open line",       NULL,  "o\x1b",      500,  NULL},
+    {"open comment",    NULL,  "O/*\x1b",    50,   NULL},
+    {"visual extend",   "v",   "j",          1000, "\x1b"},
+    {"find in row",     NULL,  "0fx",        500,  NULL},
+    {"search",          NULL,  "/main\r",    100,  NULL},
+    {"top and bottom",  NULL,  "ggGG",       100,  NULL},
+    {"edit far above",  NULL,  "150000k3jx150000j", 25, NULL},
+    {"insert tab",      "i",   "\t",         500,  "\x1b"},
+    // a comment opened on one row and a row edited a screen above it before the next redraw;
+    // inside a script "\x1b[x" is a whole unknown key sequence, which reads as a plain escape
+    {"edits in batch",  "150000k100jo/*x*/\x1b[x", "o/*\x1b[x40kx", 1, "100j"},
+};
+#define BENCH_OPS (sizeof(bench_ops) / sizeof(bench_ops[0]))
+
+/*** data ***/
+
+extern struct editorConfig E;
+
+void initEditor(int screenrows, int screencols);
+void editorOpen(char *filename);
+void editorProccessKeyPress();
+
+static int bench_keys;
+
+/*** helpers ***/
+
+static int benchCompare(const void *a, const void *b){
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double benchPercentile(double *samples, int n, double p){
+    int i = (int)(p * (n - 1) + 0.5);
+    return samples[i];
+}
+
+// queues keys on the fake stdin and runs the mode functions until they are consumed
+static void benchFeed(const char *keys){
+    if (keys == NULL){
+        return;
+    }
+    size_t len = strlen(keys);
+    if (write(bench_keys, keys, len) != (ssize_t)len){
+        die("bench write keys");
+    }
+
+    int pending;
+    while (ioctl(STDIN_FILENO, FIONREAD, &pending) == 0 && pending > 0){
+        editorProccessKeyPress();
+    }
+}
+
+static char *benchWriteFile(const char *dir, const char *name, const char *contents){
+    char *path = malloc(strlen(dir) + strlen(name) + 2);
+    if (path == NULL){
+        die("bench path");
+    }
+    sprintf(path, "%s/%s", dir, name);
+
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL){
+        die("bench fopen");
+    }
+    if (contents){
+        fputs(contents, fp);
+    }else{
+        for (int i = 0; i < BENCH_LINES; i += 6){
+            fprintf(fp, "int main(void) {\n");
+            fprintf(fp, "\t/* comment %d\n", i);
+            fprintf(fp, "\t   still comment */ x = %d.5;\n", i);
+            fprintf(fp, "\tchar *s = \"str\\\"ing\"; // tail %d\n", i);
+            fprintf(fp, "\tfor (int j = 0; j < 10; j++) return j;\n");
+            fprintf(fp, "}\n");
+        }
+    }
+    fclose(fp);
+
+    return path;
+}
+
+/*** main ***/
+
+int main(){
+    char dir[] = "/tmp/kilo-bench-XXXXXX";
+    if (mkdtemp(dir) == NULL){
+        die("bench mkdtemp");
+    }
+    char *ini = benchWriteFile(dir, ".kilorc.ini",
+                               "[editor]\nindent = tab\nindent_amount = 4\nline_numbers = true\nsyntax = true\n");
+    char *file = benchWriteFile(dir, "bench.c", NULL);
+    setenv("HOME", dir, 1);
+
+    // the report keeps the real stdout; frames go to /dev/null and keys come from a pipe
+    FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+    int null_fd = open("/dev/null", O_WRONLY);
+    int keys[2];
+    if (report == NULL || null_fd == -1 || pipe(keys) == -1){
+        die("bench setup");
+    }
+    dup2(null_fd, STDOUT_FILENO);
+    dup2(keys[0], STDIN_FILENO);
+    fcntl(STDIN_FILENO, F_SETFL, O_NONBLOCK);
+    bench_keys = keys[1];
+
+    initEditor(BENCH_ROWS, BENCH_COLS);
+    double start = perfNow();
+    editorOpen(file);
+    double open_us = perfNow() - start;
+    editorRefreshScreen(&E);
+
+    fprintf(report, "kilo bench: %d lines, %dx%d virtual screen, open %.0f us\n\n",
+            E.numrows, BENCH_COLS, BENCH_ROWS, open_us);
+    fprintf(report, "%-16s %6s %10s %10s %10s %10s %12s %12s\n",
+            "operation", "ops", "p50 us", "p90 us", "p99 us", "max us", "avg B/frame", "max B/frame");
+
+    for (unsigned int i = 0; i < BENCH_OPS; i++){
+        benchOp *op = &bench_ops[i];
+        double *samples = malloc(sizeof(double) * op->times);
+        if (samples == NULL){
+            die("bench samples");
+        }
+        size_t total_bytes = 0;
+        size_t max_bytes = 0;
+
+        benchFeed(op->setup);
+        editorRefreshScreen(&E);
+        for (int n = 0; n < op->times; n++){
+            double t = perfNow();
+            benchFeed(op->keys);
+            editorRefreshScreen(&E);
+            samples[n] = perfNow() - t;
+
+            total_bytes += E.frame_bytes;
+            if (E.frame_bytes > max_bytes){
+                max_bytes = E.frame_bytes;
+            }
+        }
+        benchFeed(op->teardown);
+        editorRefreshScreen(&E);
+        int stale = editorCheckSyntaxStates(&E);
+        if (stale != -1){
+            fprintf(report, "%s: stale syntax state at row %d\n", op->name, stale);
+            return 1;
+        }
+
+        qsort(samples, op->times, sizeof(double), benchCompare);
+        fprintf(report, "%-16s %6d %10.1f %10.1f %10.1f %10.1f %12zu %12zu\n",
+                op->name, op->times,
+                benchPercentile(samples, op->times, 0.50),
+                benchPercentile(samples, op->times, 0.90),
+                benchPercentile(samples, op->times, 0.99),
+                samples[op->times - 1],
+                total_bytes / op->times, max_bytes);
+        free(samples);
+    }
+    fflush(report);
+
+    unlink(file);
+    unlink(ini);
+    rmdir(dir);
+    free(file);
+    free(ini);
+    return 0;
+}
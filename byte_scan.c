@@ -0,0 +1,63 @@
+#include "byte_scan.h"
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// offset of the first byte of s[0, len) that is one of the nset (at most BS_SET_MAX) bytes of set,
+// or len. blocks are compared against every byte of set at once; the tail falls back to bytes
+int bsFindAny(const char *s, int len, const char *set, int nset){
+    if (nset <= 0){
+        return len;
+    }
+    if (nset == 1){
+        const char *p = memchr(s, set[0], len);
+        return p ? p - s : len;
+    }
+
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i wide[BS_SET_MAX];
+    for (int k = 0; k < nset; k++){
+        wide[k] = _mm256_set1_epi8(set[k]);
+    }
+    for (; i + 32 <= len; i += 32){
+        __m256i block = _mm256_loadu_si256((const __m256i *)(s + i));
+        __m256i hit = _mm256_cmpeq_epi8(block, wide[0]);
+        for (int k = 1; k < nset; k++){
+            hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(block, wide[k]));
+        }
+        unsigned int mask = _mm256_movemask_epi8(hit);
+        if (mask){
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    __m128i narrow[BS_SET_MAX];
+    for (int k = 0; k < nset; k++){
+        narrow[k] = _mm_set1_epi8(set[k]);
+    }
+    for (; i + 16 <= len; i += 16){
+        __m128i block = _mm_loadu_si128((const __m128i *)(s + i));
+        __m128i hit = _mm_cmpeq_epi8(block, narrow[0]);
+        for (int k = 1; k < nset; k++){
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(block, narrow[k]));
+        }
+        unsigned int mask = _mm_movemask_epi8(hit);
+        if (mask){
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < len; i++){
+        for (int k = 0; k < nset; k++){
+            if (s[i] == set[k]){
+                return i;
+            }
+        }
+    }
+    return len;
+}
@@ -0,0 +1,8 @@
+#ifndef KILO_BYTE_SCAN_H
+#define KILO_BYTE_SCAN_H
+
+#define BS_SET_MAX 8
+
+int bsFindAny(const char *s, int len, const char *set, int nset);
+
+#endif
@@ -4,15 +4,15 @@
 #include "screen.h"
 
 void editorMoveCursorCommand_(editorConfig *config, int count, EDITOR_MOTIONS motion){
-    erow *row = ((*config).cy >= (*config).numrows) ? NULL : &(*config).row[(*config).cy];
+    erow *row = ((*config).cy >= (*config).numrows) ? NULL : editorRenderedRowAt(config, (*config).cy);
 
     switch (motion) {
         case UP:{
             if ((*config).cy != 0){
                 (*config).cy = max((*config).cy - count, 0);
                 (*config).cx = (*config).last_cx;
-                if ((*config).cx > (*config).row[(*config).cy].rsize + (*config).last_row_digits - 1){
-                    (*config).cx = (*config).row[(*config).cy].rsize + (*config).last_row_digits - 1;
+                if ((*config).cx > editorRenderedRowAt(config, (*config).cy)->rsize + (*config).last_row_digits - 1){
+                    (*config).cx = editorRenderedRowAt(config, (*config).cy)->rsize + (*config).last_row_digits - 1;
                 }
             }
             break;
@@ -22,8 +22,8 @@ void editorMoveCursorCommand_(editorConfig *config, int count, EDITOR_MOTIONS mo
             if ((*config).cy < (*config).numrows - 1){
                 (*config).cy = min((*config).cy + count, (*config).numrows - 1);
                 (*config).cx = (*config).last_cx;
-                if ((*config).cx > (*config).row[(*config).cy].rsize + (*config).last_row_digits - 1){
-                    (*config).cx = (*config).row[(*config).cy].rsize + (*config).last_row_digits - 1;
+                if ((*config).cx > editorRenderedRowAt(config, (*config).cy)->rsize + (*config).last_row_digits - 1){
+                    (*config).cx = editorRenderedRowAt(config, (*config).cy)->rsize + (*config).last_row_digits - 1;
                 }
             }
             break;
@@ -35,7 +35,7 @@ void editorMoveCursorCommand_(editorConfig *config, int count, EDITOR_MOTIONS mo
                 (*config).last_cx = (*config).cx;
             }
             else if ((*config).cy > 0){
-                (*config).cx = (*config).row[--(*config).cy].rsize + (*config).last_row_digits - 1;
+                (*config).cx = editorRenderedRowAt(config, --(*config).cy)->rsize + (*config).last_row_digits - 1;
                 (*config).last_cx = (*config).cx;
             }
 
@@ -62,7 +62,7 @@ void editorMoveCursorCommand_(editorConfig *config, int count, EDITOR_MOTIONS mo
 
         case END_LINE:{
             if ((*config).cy < (*config).numrows){
-                (*config).cx = (*config).row[(*config).cy].rsize + (*config).last_row_digits - 1;
+                (*config).cx = editorRenderedRowAt(config, (*config).cy)->rsize + (*config).last_row_digits - 1;
                 (*config).last_cx = (*config).cx;
             }
             break;
@@ -101,7 +101,7 @@ void editorMoveCursorCommand_(editorConfig *config, int count, EDITOR_MOTIONS mo
         }
     }
 
-    row = ((*config).cy >= (*config).numrows) ? NULL : &(*config).row[(*config).cy];
+    row = ((*config).cy >= (*config).numrows) ? NULL : editorRenderedRowAt(config, (*config).cy);
     int rowlen = row ? row->rsize : 0;
     if (editor_cx_to_index(config) > rowlen){
         (*config).cx = rowlen + (*config).last_row_digits;
@@ -116,7 +116,7 @@ char *editorBufToString(editorConfig *config){
     int buf_size = 0;
 
     int start_idx = (start_row == (*config).cy) ? editor_cx_to_index(config) : (*config).vhl_start;
-    int end_idx = (*config).row[start_row].rsize;
+    int end_idx = editorRowAt(config, start_row)->size;
     if (start_row == end_row) {
         if (editor_cx_to_index(config) > (*config).vhl_start){
             start_idx = (*config).vhl_start;
@@ -131,7 +131,7 @@ char *editorBufToString(editorConfig *config){
             perror("Malloc failed");
             exit(EXIT_FAILURE);
         }
-        strncpy(buf, &(*config).row[start_row].chars[start_idx], end_idx - start_idx);
+        strncpy(buf, &editorRowChars(editorRowAt(config, start_row))[start_idx], end_idx - start_idx);
         buf[end_idx - start_idx] = '\n';
         buf[end_idx - start_idx + 1] = '\0';
         return buf;
@@ -143,12 +143,13 @@ char *editorBufToString(editorConfig *config){
         perror("Malloc failed");
         exit(EXIT_FAILURE);
     }
-    strncpy(buf, &(*config).row[start_row].chars[start_idx], end_idx - start_idx);
+    strncpy(buf, &editorRowChars(editorRowAt(config, start_row))[start_idx], end_idx - start_idx);
     buf[end_idx - start_idx] = '\n';
     buf[end_idx - start_idx + 1] = '\0';
 
     for (int y = start_row + 1; y < end_row; y++) {
-        buf_size += (*config).row[y].size + 1;
+        erow *row = editorRowAt(config, y);
+        buf_size += row->size + 1;
         char *temp = realloc(buf, buf_size + 1);
         if (!temp) {
             free(buf);
@@ -157,7 +158,7 @@ char *editorBufToString(editorConfig *config){
         }
         buf = temp;
 
-        strncat(buf, (*config).row[y].chars, (*config).row[y].size);
+        strncat(buf, editorRowChars(row), row->size);
         strcat(buf, "\n");
     }
 
@@ -171,7 +172,7 @@ char *editorBufToString(editorConfig *config){
     }
     buf = temp;
 
-    strncat(buf, (*config).row[end_row].chars, end_idx);
+    strncat(buf, editorRowChars(editorRowAt(config, end_row)), end_idx);
     strcat(buf, "\n");
 
     return buf;
@@ -183,6 +184,8 @@ void editorYankCommand_(editorConfig *config, int count, int motion){
         char *buf = editorBufToString(config);
         editorResetHighlight(config);
         editorRefreshScreen(config);
+        // xclip shares the terminal and may print over what the screen diff thinks is there
+        (*config).full_redraw = true;
         FILE *fp = popen("xclip -selection clipboard", "w");
         if (fp == NULL) {
             free(buf);
@@ -197,17 +200,19 @@ void editorYankCommand_(editorConfig *config, int count, int motion){
     }
 
     if (motion == YANK_LINE){
-        if (config->cy < 0 || config->cy > config->numrows){
+        if (config->cy < 0 || config->cy >= config->numrows){
             return;
         }
 
+        (*config).full_redraw = true;
         FILE *fp = popen("xclip -selection clipboard", "w");
         if (fp == NULL) {
             perror("Failed to run xclip");
             return;
         }
 
-        fprintf(fp, "%s", (*config).row[(*config).cy].chars);
+        erow *row = editorRowAt(config, (*config).cy);
+        fwrite(editorRowChars(row), 1, row->size, fp);
         pclose(fp);
         return;
     }
@@ -220,6 +225,7 @@ void editorYankCommand_(editorConfig *config, int count, int motion){
 }
 
 void editorPasteCommand_(editorConfig *config, int count, int motion){
+    (*config).full_redraw = true;
     FILE *fp = popen("xclip -selection clipboard -o", "r");
     if (fp == NULL) {
         die("Failed to run xclip");
@@ -229,46 +235,33 @@ void editorPasteCommand_(editorConfig *config, int count, int motion){
     size_t size = 0;
 
     ssize_t read = getdelim(&buffer, &size, '\0', fp);
-    if (read != -1) {
-        buffer[read] = '\0';
-    } else {
+    if (read == -1) {
         perror("Failed to read clipboard data");
+        free(buffer);
+        pclose(fp);
+        return;
     }
 
     int start = 0;
     int end = 0;
     int row_index = (*config).cy;
-    char *first_row_start = malloc(sizeof(char) * (editor_cx_to_index(config) + 1));
-    if (first_row_start == NULL){
-        free(buffer);
-        die("editor paste");
-    }
-    char *first_row_end = malloc(sizeof(char) * ((*config).row[row_index].size - editor_cx_to_index(config) + 1));
-    if (first_row_end == NULL){
+    int at = editor_cx_to_index(config);
+    erow *row = editorRowAt(config, row_index);
+    int tail_len = row->size - at;
+    char *tail = malloc(sizeof(char) * (tail_len + 1));
+    if (tail == NULL){
         free(buffer);
-        free(first_row_start);
         die("editor paste");
     }
-
-    strncpy(first_row_start, (*config).row[row_index].chars, editor_cx_to_index(config));
-    first_row_start[editor_cx_to_index(config)] = '\0';
-    strcpy(first_row_end, &(*config).row[row_index].chars[editor_cx_to_index(config)]);
+    memcpy(tail, &editorRowChars(row)[at], tail_len);
+    editorRowTruncate(config, row, at);
 
     while (end <= read) {
         if (end == read || buffer[end] == '\n' || buffer[end] == '\r') {
             int line_len = end - start;
 
             if (row_index == (*config).cy) {
-                erow *row = &(*config).row[row_index];
-                row->size = editor_cx_to_index(config) + line_len;
-                row->chars = realloc(row->chars, row->size + 1);
-                if (!row->chars) {
-                    die("editor paste");
-                }
-
-                strncpy(&row->chars[editor_cx_to_index(config)], &buffer[start], line_len);
-                row->chars[row->size] = '\0';
-                editorUpdateRow(config, row);
+                editorRowAppendString(config, editorRowAt(config, row_index), &buffer[start], line_len);
             } else {
                 editorInsertRow(config, row_index, &buffer[start], line_len);
             }
@@ -279,32 +272,24 @@ void editorPasteCommand_(editorConfig *config, int count, int motion){
         end++;
     }
 
-    erow *last_row = &(*config).row[row_index - 1];
-    last_row->size += strlen(first_row_end);
-    last_row->chars = realloc(last_row->chars, last_row->size + 1);
-    if (!last_row->chars) {
-        die("editor paste");
-    }
-
-    strcat(last_row->chars, first_row_end);
-    editorUpdateRow(&(*config), last_row);
+    editorRowAppendString(config, editorRowAt(config, row_index - 1), tail, tail_len);
 
-    free(first_row_start);
-    free(first_row_end);
+    free(tail);
     free(buffer);
     pclose(fp);
     editorRefreshScreen(&(*config));
 }
 
 void editorSearchCommand_(editorConfig *config, int count, EDITOR_MOTIONS motion, int c){
-    if ((*config).cy < 0 || (*config).cy > (*config).numrows){
+    if ((*config).cy < 0 || (*config).cy >= (*config).numrows){
         return;
     }
-    erow row = (*config).row[(*config).cy];
+    erow *row = editorRowAt(config, (*config).cy);
+    char *chars = editorRowChars(row);
     if (motion == SEARCH_FORWARD){
         int last = -1;
-        for (int i = editor_cx_to_index(&(*config)) + 1; i < row.size; i++){
-            if (row.chars[i] == c){
+        for (int i = editor_cx_to_index(&(*config)) + 1; i < row->size; i++){
+            if (chars[i] == c){
                 if (--count > 0){
                     last = i;
                 }else{
@@ -323,7 +308,7 @@ void editorSearchCommand_(editorConfig *config, int count, EDITOR_MOTIONS motion
     }
     int last = -1;
     for (int i = editor_cx_to_index(&(*config)) - 1; i >= 0; i--){
-        if (row.chars[i] == c){
+        if (chars[i] == c){
                 if (--count > 0){
                     last = i;
                 }else{
@@ -349,16 +334,17 @@ void editorChangeCaseCommand_(editorConfig *config, int count, EDITOR_MOTIONS mo
 }
 
 void editorReplaceCommand_(editorConfig *config, int count, EDITOR_MOTIONS motion, int to){
-    if ((*config).cy < 0 || (*config).cy > (*config).numrows){
+    if ((*config).cy < 0 || (*config).cy >= (*config).numrows){
         return;
     }
 
-    erow row = (*config).row[(*config).cy];
-    if (editor_cx_to_index(config) > row.size){
+    erow *row = editorRowAt(config, (*config).cy);
+    int at = editor_cx_to_index(config);
+    if (at >= row->size){
         return;
     }
 
-    row.chars[editor_cx_to_index(config)] = to;
-    editorUpdateRow(config, &row);
+    editorRowDelChar(config, row, at);
+    editorRowInsertChar(config, row, at, to);
     editorRefreshScreen(config);
 }
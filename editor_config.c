@@ -34,12 +34,18 @@ HashTable *init_config(){
     bool relative_line_numbers= "false";
     bool syntax = "true";
     int quit_times = 3;
+    int max_latency = 16;
+    bool perf_overlay = false;
+    bool soft_wrap = false;
     ht_insert(config, "indent_amount", &indent_amount, sizeof(int), TYPE_INT);
     ht_insert(config, "indent", indent, (sizeof(char) * strlen(indent)) + 1, TYPE_STR);
     ht_insert(config, "line_numbers", &line_numbers, sizeof(_Bool), TYPE_BOOL);
     ht_insert(config, "relative_line_numbers", &relative_line_numbers, sizeof(_Bool), TYPE_BOOL);
     ht_insert(config, "syntax", &syntax, sizeof(_Bool), TYPE_BOOL);
     ht_insert(config, "quit_times", &quit_times, sizeof(int), TYPE_INT);
+    ht_insert(config, "max_latency", &max_latency, sizeof(int), TYPE_INT);
+    ht_insert(config, "perf_overlay", &perf_overlay, sizeof(_Bool), TYPE_BOOL);
+    ht_insert(config, "soft_wrap", &soft_wrap, sizeof(_Bool), TYPE_BOOL);
 
     return config;
 }
@@ -59,7 +65,7 @@ Ini *load_config(){
 }
 
 int init_kilo_config(editorConfig* kilo_config){
-    char *included[6] = {"indent_amount", "indent", "line_numbers", "syntax", "quit_times", "relative_line_numbers"};
+    char *included[9] = {"indent_amount", "indent", "line_numbers", "syntax", "quit_times", "relative_line_numbers", "max_latency", "perf_overlay", "soft_wrap"};
 
     HashTable *editor_config = init_config();
     if (editor_config == NULL){
@@ -82,7 +88,7 @@ int init_kilo_config(editorConfig* kilo_config){
     }
     
     HashTable *editor_section = (HashTable *)editor_section_item->value;
-    for (int i = 0; i < 6; i++){
+    for (int i = 0; i < 9; i++){
         char *curr = included[i];
 
         Ht_item *editor_item = ht_search(editor_config, curr);
@@ -154,7 +160,7 @@ int init_kilo_config(editorConfig* kilo_config){
         }
     }
 
-    for (int i = 0; i < 6; i++){
+    for (int i = 0; i < 9; i++){
         Ht_item* editor_item = ht_search(editor_config, included[i]);
         switch (i) {
             case 0:{
@@ -188,6 +194,19 @@ int init_kilo_config(editorConfig* kilo_config){
                 if (kilo_config->relative_line_numbers){
                     kilo_config->line_numbers = true;
                 }
+                break;
+            }
+            case 6:{
+                kilo_config->max_latency = (*(int *)editor_item->value);
+                break;
+            }
+            case 7:{
+                kilo_config->perf.enabled = (*(bool *)editor_item->value);
+                break;
+            }
+            case 8:{
+                kilo_config->soft_wrap = (*(bool *)editor_item->value);
+                break;
             }
             default:{
                 break;
@@ -4,6 +4,11 @@
 #include <time.h>
 #include <termios.h>
 #include "ini_parser.h"
+#include "piece_table.h"
+#include "row_tree.h"
+#include "append_buffer.h"
+#include "perf.h"
+#include "keyword_table.h"
 
 typedef struct editorSyntax {
     char *filetype;
@@ -13,17 +18,56 @@ typedef struct editorSyntax {
     char *multiline_comment_start;
     char *multiline_comment_end;
     int flags;
+    char *separators;
+    char *strings;
+    keywordTable keyword_table;
+    unsigned char byte_class[256];
+    bool compiled;
 } editorSyntax;
 
+// highlighter state carried from one column to the next
+typedef struct hlState{
+    int in_comment;
+    int in_string;
+    int in_line_comment;
+    int prev_sep;
+    int prev_number;
+}hlState;
+
+typedef struct hlCheckpoint{
+    int cx;
+    hlState state;
+}hlCheckpoint;
+
 typedef struct erow{
-    int idx;
     int size;
     int rsize;
     char *chars;
     char *render;
-    unsigned char *vhl;
     unsigned char *hl;
+    int render_off;
+    int render_len;
+    int render_cx;
     int hl_open_comment;
+    int hl_scan_entry;
+    unsigned int hl_version;
+    int hl_entry;
+    hlCheckpoint *checkpoints;
+    int ncheckpoints;
+    int checkpoints_cap;
+    int checkpoints_entry;
+    bool owned;
+    struct rowNode *block;
+    struct gapBuffer *gap;
+    bool gap_dirty;
+    int *tabs;
+    int ntabs;
+    int tabs_cap;
+    bool tabs_valid;
+    int wrap_lines;
+    int wrap_cols;
+    struct erow *lru_prev;
+    struct erow *lru_next;
 }erow;
 
 typedef enum Indent{
@@ -43,6 +87,8 @@ typedef struct editorConfig{
     int os_type;
     int cx, cy;
     int rowoff, coloff;
+    int wrapoff, lineoff;
+    int cursor_sy, cursor_sx;
     int rx;
     int last_cx;
     int screenrows;
@@ -52,15 +98,36 @@ typedef struct editorConfig{
     int last_row_digits;
     int quit_times;
     int quit_times_curr;
+    int max_latency;
     int indent_amount;
     int vhl_start, vhl_row;
+    bool vhl_active;
     Indent indent;
     Mode mode;
     bool line_numbers;
     bool relative_line_numbers;
+    bool soft_wrap;
     bool syntax_flag;
-    erow *row;
+    rowTree rows;
+    erow *gap_row;
+    erow *lru_head;
+    erow *lru_tail;
+    int lru_count;
+    int hl_frontier;
+    erow *hl_scan_last;
+    unsigned int hl_generation;
+    unsigned int hl_versions;
+    pieceTable pt;
     int dirty;
+    struct abuf frame;
+    size_t frame_bytes;
+    perfStats perf;
+    struct screenCell *screen_prev;
+    struct screenCell *screen_next;
+    int screen_rows, screen_cols;
+    int screen_lineoff;
+    bool full_redraw;
+    bool sync_output;
     char *filename;
     char statusmsg[80];
     time_t statusmsg_time;
@@ -69,6 +136,7 @@ typedef struct editorConfig{
     ModeFn mode_functions[3];
 } editorConfig;
 
+char *expand_path(const char *path);
 int init_kilo_config(editorConfig* kilo_config);
 
 #endif
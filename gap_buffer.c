@@ -0,0 +1,92 @@
+#include "gap_buffer.h"
+#include "utils.h"
+
+gapBuffer *gbNew(const char *s, int len){
+    gapBuffer *gb = malloc(sizeof(gapBuffer));
+    if (gb == NULL){
+        die("gap buffer");
+    }
+
+    gb->cap = len + GB_MIN_GAP;
+    gb->buf = malloc(gb->cap);
+    if (gb->buf == NULL){
+        die("gap buffer");
+    }
+    memcpy(gb->buf, s, len);
+    gb->gap_start = len;
+    gb->gap_end = gb->cap;
+
+    return gb;
+}
+
+void gbFree(gapBuffer *gb){
+    if (gb == NULL){
+        return;
+    }
+    free(gb->buf);
+    free(gb);
+}
+
+static void gbGrow(gapBuffer *gb, int need){
+    int tail = gb->cap - gb->gap_end;
+    int cap = gb->cap * 2;
+    if (cap < gbLength(gb) + need + GB_MIN_GAP){
+        cap = gbLength(gb) + need + GB_MIN_GAP;
+    }
+
+    char *buf = malloc(cap);
+    if (buf == NULL){
+        die("gap buffer grow");
+    }
+    memcpy(buf, gb->buf, gb->gap_start);
+    memcpy(&buf[cap - tail], &gb->buf[gb->gap_end], tail);
+    free(gb->buf);
+
+    gb->buf = buf;
+    gb->cap = cap;
+    gb->gap_end = cap - tail;
+}
+
+static void gbMoveGap(gapBuffer *gb, int at){
+    if (at < gb->gap_start){
+        int n = gb->gap_start - at;
+        memmove(&gb->buf[gb->gap_end - n], &gb->buf[at], n);
+        gb->gap_start -= n;
+        gb->gap_end -= n;
+    }else if (at > gb->gap_start){
+        int n = at - gb->gap_start;
+        memmove(&gb->buf[gb->gap_start], &gb->buf[gb->gap_end], n);
+        gb->gap_start += n;
+        gb->gap_end += n;
+    }
+}
+
+void gbInsert(gapBuffer *gb, int at, const char *s, int len){
+    if (gb->gap_end - gb->gap_start < len){
+        gbGrow(gb, len);
+    }
+    gbMoveGap(gb, at);
+    memcpy(&gb->buf[gb->gap_start], s, len);
+    gb->gap_start += len;
+}
+
+void gbDelete(gapBuffer *gb, int at, int len){
+    gbMoveGap(gb, at);
+    gb->gap_end += len;
+}
+
+int gbLength(gapBuffer *gb){
+    return gb->cap - (gb->gap_end - gb->gap_start);
+}
+
+void gbSegments(gapBuffer *gb, const char **a, int *alen, const char **b, int *blen){
+    *a = gb->buf;
+    *alen = gb->gap_start;
+    *b = &gb->buf[gb->gap_end];
+    *blen = gb->cap - gb->gap_end;
+}
+
+void gbCopy(gapBuffer *gb, char *dst){
+    memcpy(dst, gb->buf, gb->gap_start);
+    memcpy(&dst[gb->gap_start], &gb->buf[gb->gap_end], gb->cap - gb->gap_end);
+}
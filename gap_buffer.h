@@ -0,0 +1,21 @@
+#ifndef KILO_GAP_BUFFER_H
+#define KILO_GAP_BUFFER_H
+
+#define GB_MIN_GAP 64
+
+typedef struct gapBuffer{
+    char *buf;
+    int cap;
+    int gap_start;
+    int gap_end;
+}gapBuffer;
+
+gapBuffer *gbNew(const char *s, int len);
+void gbFree(gapBuffer *gb);
+void gbInsert(gapBuffer *gb, int at, const char *s, int len);
+void gbDelete(gapBuffer *gb, int at, int len);
+int gbLength(gapBuffer *gb);
+void gbSegments(gapBuffer *gb, const char **a, int *alen, const char **b, int *blen);
+void gbCopy(gapBuffer *gb, char *dst);
+
+#endif
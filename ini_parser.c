@@ -69,10 +69,15 @@ char *parse_comment(FILE *file, int *len){
         }
     }
 
-    if (comment){
-        free(comment);
+    // a comment on the last line may end the file without a newline
+    if (*len >= size){
+        comment = realloc(comment, sizeof(char) * (size + 1));
+        if (comment == NULL){
+            return NULL;
+        }
     }
-    return NULL;
+    comment[(*len)] = '\0';
+    return comment;
 }
 
 char *parse_section(FILE *file, int *len){
@@ -134,12 +139,27 @@ char *parse_section(FILE *file, int *len){
     return NULL;
 }
 
+static int append_char(char **s, int *len, int *size, char c){
+    if (*len >= *size) {
+        char *temp = realloc(*s, ++(*size));
+        if (temp == NULL) {
+            return 0;
+        }
+        *s = temp;
+    }
+    (*s)[(*len)++] = c;
+    return 1;
+}
+
 int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val) {
     char buf;
     int is_key = 1;
     int key_size = 128;
     int val_size = 128;
 
+    *key = NULL;
+    *val = NULL;
+
     int ret = fseek(file, -1, SEEK_CUR);
     if (ret != 0){
         return 0;
@@ -153,11 +173,28 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
     *val = malloc(sizeof(char) * val_size);
     if (*val == NULL) {
         free(*key);
+        *key = NULL;
         return 0;
     }
 
     char q = -1;
-    while ((buf = fgetc(file)) != EOF) {
+    int c;
+    // the end of the file ends the last line like a newline, unless a quote is still open
+    while ((c = fgetc(file)) != EOF || q == -1) {
+        buf = c == EOF ? '\n' : c;
+        // inside quotes comment characters, ']' and the other quote are part of the value
+        if (q != -1 && buf != q && buf != '\n' && buf != '\r'){
+            int ok = is_key ? append_char(key, key_len, &key_size, buf) : append_char(val, val_len, &val_size, buf);
+            if (!ok){
+                free(*key);
+                free(*val);
+                *key = NULL;
+                *val = NULL;
+                return 0;
+            }
+            continue;
+        }
+
         switch (buf) {
             case '"':
             case '\'':{
@@ -170,6 +207,8 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                     if (*val != NULL){
                         free(*val);
                     }
+                    *key = NULL;
+                    *val = NULL;
                     return 0;
                 }else{
                     q = -1;
@@ -185,6 +224,8 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                 if (*val != NULL){
                     free(*val);
                 }
+                *key = NULL;
+                *val = NULL;
                 return 0;
             }
 
@@ -199,6 +240,8 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                     if (*val != NULL){
                         free(*val);
                     }
+                    *key = NULL;
+                    *val = NULL;
                     return 0;
                 }
                 if (buf == '#' || buf == ';'){
@@ -211,6 +254,8 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                         if (*val != NULL){
                             free(*val);
                         }
+                        *key = NULL;
+                        *val = NULL;
                         return 0;
                     }
                     //printf("found inlince comment %s\n", comment);
@@ -220,6 +265,7 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                     *key = realloc(*key, ++key_size);
                     if (*key == NULL){
                         free(*val);
+                        *val = NULL;
                         return 0;
                     }
                 }
@@ -230,6 +276,7 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                     *val= realloc(*val, val_size);
                     if (*val == NULL){
                         free(*key);
+                        *key = NULL;
                         return 0;
                     }
                 }
@@ -247,6 +294,7 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                         *val = realloc(*val, ++val_size);
                         if (*val == NULL) {
                             free(*key);
+                            *key = NULL;
                             return 0;
                         }
                     }
@@ -260,6 +308,8 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                     if (*val != NULL){
                         free(*val);
                     }
+                    *key = NULL;
+                    *val = NULL;
                     return 0;
                 }
                 is_key = 0;
@@ -273,6 +323,7 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                         *key = realloc(*key, ++key_size);
                         if (*key == NULL) {
                             free(*val);
+                            *val = NULL;
                             return 0;
                         }
                     }
@@ -282,6 +333,7 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
                         *val = realloc(*val, ++val_size);
                         if (*val == NULL) {
                             free(*key);
+                            *key = NULL;
                             return 0;
                         }
                     }
@@ -298,6 +350,8 @@ int parse_key_val(FILE *file, int *key_len, int *val_len, char **key, char **val
     if (*val != NULL){
         free(*val);
     }
+    *key = NULL;
+    *val = NULL;
     return 0;
 }
 
@@ -404,8 +458,8 @@ Ini *parse_ini(const char *filename){
                     return NULL;
                 }
 
-                char *key;
-                char *val;
+                char *key = NULL;
+                char *val = NULL;
                 int key_len = 0;
                 int val_len = 0;
                 int res = parse_key_val(file, &key_len, &val_len, &key, &val);
@@ -0,0 +1,89 @@
+#include "keyword_table.h"
+#include "utils.h"
+
+static unsigned int kwHash(unsigned int seed, const char *s, int len){
+    unsigned int hash = 2166136261u ^ seed;
+    for (int i = 0; i < len; i++){
+        hash = (hash ^ (unsigned char)s[i]) * 16777619u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+// places every keyword with the given seed, failing on the first collision
+static bool kwPlace(keywordTable *kw, char **keywords){
+    memset(kw->slots, 0, sizeof(kwSlot) * (kw->mask + 1));
+    for (int j = 0; keywords[j]; j++){
+        int len = strlen(keywords[j]);
+        int kind = KW_KIND_PRIMARY;
+        if (len > 0 && keywords[j][len - 1] == '|'){
+            kind = KW_KIND_SECONDARY;
+            len--;
+        }
+        if (len == 0){
+            continue;
+        }
+
+        kwSlot *slot = &kw->slots[kwHash(kw->seed, keywords[j], len) & kw->mask];
+        if (slot->word){
+            // a repeated keyword keeps its first kind, as the linear scan did
+            if (slot->len == len && !memcmp(slot->word, keywords[j], len)){
+                continue;
+            }
+            return false;
+        }
+        *slot = (kwSlot){keywords[j], len, kind};
+        kw->max_len = max(kw->max_len, len);
+    }
+    return true;
+}
+
+// keywords are matched as whole words, so the trailing '|' of secondary keywords is stripped here once
+void kwBuild(keywordTable *kw, char **keywords){
+    static char *none[] = {NULL};
+    if (keywords == NULL){
+        keywords = none;
+    }
+
+    int count = 0;
+    while (keywords[count]){
+        count++;
+    }
+
+    unsigned int size = 16;
+    while (size < (unsigned int)count * 2){
+        size <<= 1;
+    }
+
+    kw->max_len = 0;
+    kw->slots = NULL;
+    for (;; size <<= 1){
+        kw->slots = realloc(kw->slots, sizeof(kwSlot) * size);
+        if (kw->slots == NULL){
+            die("keyword table");
+        }
+        kw->mask = size - 1;
+        for (kw->seed = 0; kw->seed < 64; kw->seed++){
+            kw->max_len = 0;
+            if (kwPlace(kw, keywords)){
+                return;
+            }
+        }
+    }
+}
+
+// returns the keyword kind of s[0, len), or 0 when it is not a keyword
+int kwLookup(keywordTable *kw, const char *s, int len){
+    if (len > kw->max_len){
+        return 0;
+    }
+    kwSlot *slot = &kw->slots[kwHash(kw->seed, s, len) & kw->mask];
+    if (slot->len == len && slot->word && !memcmp(slot->word, s, len)){
+        return slot->kind;
+    }
+    return 0;
+}
+
+void kwFree(keywordTable *kw){
+    free(kw->slots);
+    kw->slots = NULL;
+}
@@ -0,0 +1,27 @@
+#ifndef KILO_KEYWORD_TABLE_H
+#define KILO_KEYWORD_TABLE_H
+
+#include <stdbool.h>
+
+#define KW_KIND_PRIMARY 1
+#define KW_KIND_SECONDARY 2
+
+typedef struct kwSlot{
+    const char *word;
+    int len;
+    int kind;
+}kwSlot;
+
+// collision-free hash of one syntax's keywords: a lookup is one probe and one compare
+typedef struct keywordTable{
+    kwSlot *slots;
+    unsigned int mask;
+    unsigned int seed;
+    int max_len;
+}keywordTable;
+
+void kwBuild(keywordTable *kw, char **keywords);
+int kwLookup(keywordTable *kw, const char *s, int len);
+void kwFree(keywordTable *kw);
+
+#endif
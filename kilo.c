@@ -1,11 +1,11 @@
 /*** includes ***/
 
-#include "utils.h"
-#include <stdbool.h>
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE
 #define _GNU_SOURCE
 
+#include "utils.h"
+#include <stdbool.h>
 #include <asm-generic/ioctls.h>
 #include <ctype.h>
 #include <errno.h>
@@ -16,6 +16,9 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <poll.h>
 #include <termios.h>
 #include <time.h>
 #include <unistd.h>
@@ -27,8 +30,10 @@
 #include "screen.h"
 
 /*** defines ***/
+
 #define KILO_VERSION "0.0.1"
 #define KILO_QUIT_TIMES 3
+#define SAVE_IOV_BATCH 64
 
 #define CTRL_KEY(k) ((k) & 0x1f)
 
@@ -115,10 +120,18 @@ int editorReadKey(int *count){
     char c;
     *count = 0;
 
-    while ((nread = read(STDIN_FILENO, &c, 1)) != 1) {
+    // a read that times out means the user paused, so off-screen highlighting may run until a key arrives
+    if ((nread = read(STDIN_FILENO, &c, 1)) != 1) {
         if (nread == -1 && errno != EAGAIN) {
             die("read");
         }
+        editorSyntaxIdle(true);
+        while ((nread = read(STDIN_FILENO, &c, 1)) != 1) {
+            if (nread == -1 && errno != EAGAIN) {
+                die("read");
+            }
+        }
+        editorSyntaxIdle(false);
     }
 
     while(E.mode != INSERT && '0' <= c && c <= '9'){
@@ -258,6 +271,35 @@ int getCursorPosition(int *rows, int *cols) {
     return 0;
 }
 
+// asks for DEC mode 2026 (synchronized output) with DECRQM; the trailing DA1 query is
+// answered by every terminal, so we know when to stop reading even without support
+bool getSyncOutputSupport(){
+    char buf[64];
+    unsigned int i = 0;
+
+    if (write(STDOUT_FILENO, "\x1b[?2026$p\x1b[c", 12) != 12) {
+        return false;
+    }
+    while (i < sizeof(buf) - 1) {
+        if (read(STDIN_FILENO, &buf[i], 1) != 1) {
+            break;
+        }
+        if (buf[i] == 'c') {
+            break;
+        }
+        i++;
+    }
+    buf[i] = '\0';
+
+    int mode = 0;
+    char *reply = strstr(buf, "\x1b[?2026;");
+    if (reply == NULL || sscanf(reply + 8, "%d$y", &mode) != 1){
+        return false;
+    }
+
+    return mode == 1 || mode == 2;
+}
+
 int getWindowSize(int *rows, int *cols){
     struct winsize ws;
 
@@ -281,22 +323,23 @@ void editorInsertChar(int c){
         editorInsertRow(&E, E.numrows, "", 0);
     }
     if (E.indent == SPACE && c == '\t'){
-        for (int i = 0; i < E.indent_amount; i++){
-            editorRowInsertChar(&E, &E.row[E.cy], editor_cx_to_index(&E), SPACE);
-            E.cx++;
-            E.last_cx = E.cx;
-        }
+        char spaces[E.indent_amount];
+        memset(spaces, SPACE, E.indent_amount);
+        editorRowInsertString(&E, editorRowAt(&E, E.cy), editor_cx_to_index(&E), spaces, E.indent_amount);
+        E.cx += E.indent_amount;
+        E.last_cx = E.cx;
     }else{
-        editorRowInsertChar(&E, &E.row[E.cy], editor_cx_to_index(&E), c);
+        editorRowInsertChar(&E, editorRowAt(&E, E.cy), editor_cx_to_index(&E), c);
         E.cx++;
         E.last_cx = E.cx;
     }
 }
 
 int editorCountIndent(erow *row){
+    char *chars = editorRowChars(row);
     int count = 0;
     for (int i = 0; i < row->size; i++){
-        if (row->chars[i] != E.indent){
+        if (chars[i] != E.indent){
             return count;
         }
         count++;
@@ -306,7 +349,7 @@ int editorCountIndent(erow *row){
 }
 
 void editorInsertNewlineCommand(int dir){
-    erow *row = &E.row[E.cy];
+    erow *row = editorRowAt(&E, E.cy);
     if (row != NULL){
         int indent_count = editorCountIndent(row);
         if (indent_count > 0){
@@ -324,6 +367,7 @@ void editorInsertNewlineCommand(int dir){
             }else{
                 editorInsertRow(&E, E.cy, buf, indent_count);
             }
+            free(buf);
             E.cx = E.last_row_digits + indent_count;
             E.last_cx = E.cx;
             return;
@@ -346,30 +390,28 @@ void editorInsertNewline(){
         E.cx = E.last_row_digits;
         E.last_cx = E.cx;
     }else{
-        erow *row = &E.row[E.cy];
+        erow *row = editorRowAt(&E, E.cy);
+        int at = editor_cx_to_index(&E);
         int indent_count = editorCountIndent(row);
         if (indent_count > 0){
-            char *buf = malloc(sizeof(char) * (indent_count + row->size - editor_cx_to_index(&E) + 1));
-
-            int i;
-            for (i = 0; i < indent_count; i++) {
-                buf[i] = E.indent;
+            int len = indent_count + row->size - at;
+            char *buf = malloc(sizeof(char) * (len + 1));
+            if (buf == NULL){
+                die("insert newline");
             }
 
-            buf[i] = '\0';
-
-            strcat(buf, &row->chars[editor_cx_to_index(&E)]);
-            editorInsertRow(&E, E.cy + 1, buf, indent_count + row->size - editor_cx_to_index(&E));
+            memset(buf, E.indent, indent_count);
+            memcpy(&buf[indent_count], &editorRowChars(row)[at], row->size - at);
+            editorInsertRow(&E, E.cy + 1, buf, len);
+            free(buf);
         }else {
-            editorInsertRow(&E, E.cy + 1, &row->chars[editor_cx_to_index(&E)], row->size - editor_cx_to_index(&E));
+            editorInsertRow(&E, E.cy + 1, &editorRowChars(row)[at], row->size - at);
         }
-        row = &E.row[E.cy];
-        row->size = editor_cx_to_index(&E);
-        row->chars[row->size] = '\0';
+        row = editorRowAt(&E, E.cy);
+        editorRowTruncate(&E, row, at);
         E.cy++;
         E.cx = indent_count + E.last_row_digits;
         E.last_cx = E.cx;
-        editorUpdateRow(&E, row);
     }
 }
 
@@ -378,15 +420,15 @@ void editorDeleteCommand(int amount){
         return;
     }
 
-    erow *row = &E.row[E.cy];
+    erow *row = editorRowAt(&E, E.cy);
     if (E.cx > E.last_row_digits){
         E.cx = max(E.cx - 1, E.last_row_digits);
         E.last_cx = E.cx;
         editorRowDelChar(&E, row, editor_cx_to_index(&E));
     }else{
-        E.cx = E.row[E.cy - 1].size + E.last_row_digits;
+        E.cx = editorRowAt(&E, E.cy - 1)->size + E.last_row_digits;
         E.last_cx = E.cx;
-        editorRowAppendString(&E, &E.row[E.cy - 1], row->chars, row->size);
+        editorRowAppendString(&E, editorRowAt(&E, E.cy - 1), editorRowChars(row), row->size);
         editorDelRow(&E, E.cy);
         E.cy--;
     }
@@ -397,15 +439,15 @@ void editorDelChar(){
         return;
     }
 
-    erow *row = &E.row[E.cy];
+    erow *row = editorRowAt(&E, E.cy);
     if (E.cx > E.last_row_digits){
         E.cx = max(E.cx - 1, E.last_row_digits);
         E.last_cx = E.cx;
         editorRowDelChar(&E, row, editor_cx_to_index(&E));
     }else{
-        E.cx = E.row[E.cy - 1].size + E.last_row_digits;
+        E.cx = editorRowAt(&E, E.cy - 1)->size + E.last_row_digits;
         E.last_cx = E.cx;
-        editorRowAppendString(&E, &E.row[E.cy - 1], row->chars, row->size);
+        editorRowAppendString(&E, editorRowAt(&E, E.cy - 1), editorRowChars(row), row->size);
         editorDelRow(&E, E.cy);
         E.cy--;
     }
@@ -413,25 +455,82 @@ void editorDelChar(){
 
 /*** file i/o ***/
 
-char *editorRowsToString(int *buflen){
-    int totlen = 0;
-    int j;
+typedef struct saveBatch{
+    int fd;
+    int count;
+    struct iovec iov[SAVE_IOV_BATCH];
+}saveBatch;
+
+static int editorFlushBatch(saveBatch *batch){
+    int ret = writeAll(batch->fd, batch->iov, batch->count);
+    batch->count = 0;
+    return ret;
+}
+
+static int editorBatchPiece(void *ctx, const char *s, size_t len){
+    saveBatch *batch = ctx;
+    batch->iov[batch->count].iov_base = (void *)s;
+    batch->iov[batch->count].iov_len = len;
+    if (++batch->count == SAVE_IOV_BATCH){
+        return editorFlushBatch(batch);
+    }
+    return 0;
+}
 
-    for (j = 0; j < E.numrows; j++){
-        totlen += E.row[j].size + 1;
+static void editorSyncDir(const char *filename){
+    const char *slash = strrchr(filename, '/');
+    char *dir = slash ? strndup(filename, slash - filename + 1) : strdup(".");
+    if (dir == NULL){
+        die("editor save");
     }
-    *buflen = totlen;
+    int fd = open(dir, O_RDONLY);
+    if (fd != -1){
+        fsync(fd);
+        close(fd);
+    }
+    free(dir);
+}
 
-    char *buf = malloc(totlen);
-    char *p = buf;
+size_t editorStripCarriageReturns(char *buf, size_t len){
+    if (memchr(buf, '\r', len) == NULL){
+        return len;
+    }
 
-    for (j = 0; j < E.numrows; j++){
-        memcpy(p, E.row[j].chars, E.row[j].size);
-        p += E.row[j].size;
-        *p = '\n';
-        p++;
+    size_t out = 0;
+    for (size_t i = 0; i < len; i++){
+        if (buf[i] == '\r'){
+            size_t j = i;
+            while (j < len && buf[j] == '\r'){
+                j++;
+            }
+            if (j == len || buf[j] == '\n'){
+                i = j - 1;
+                continue;
+            }
+        }
+        buf[out++] = buf[i];
     }
 
+    return out;
+}
+
+static char *editorReadFile(int fd, size_t size, size_t *len){
+    char *buf = malloc(size + 1);
+    if (buf == NULL){
+        close(fd);
+        die("editor open");
+    }
+    *len = 0;
+    while (*len < size){
+        ssize_t n = read(fd, &buf[*len], size - *len);
+        if (n == -1 && errno == EINTR){
+            continue;
+        }
+        if (n <= 0){
+            break;
+        }
+        *len += n;
+    }
     return buf;
 }
 
@@ -441,23 +540,40 @@ void editorOpen(char *filename){
 
     editorSelectSyntaxHighlight(&E);
 
-    FILE *fp = fopen(filename, "r");
-    if (!fp){
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1){
         E.dirty = 0;
         return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1){
+        close(fd);
         die("editor open");
     }
-    char *line = NULL;
-    size_t linecap;
-    ssize_t linelen;
-    while ((linelen = getline(&line, &linecap, fp)) != -1){
-        while (linelen > 0 && (line[linelen - 1] == '\r' || line[linelen - 1] == '\n')){
-            linelen --;
+
+    size_t len = st.st_size;
+    char *map = len > 0 ? mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (map != MAP_FAILED && memchr(map, '\r', len) == NULL){
+        close(fd);
+        editorLoadRows(&E, map, len, true);
+    }else{
+        char *buf;
+        if (map != MAP_FAILED){
+            buf = malloc(len);
+            if (buf == NULL){
+                die("editor open");
+            }
+            memcpy(buf, map, len);
+            munmap(map, len);
+        }else{
+            buf = editorReadFile(fd, len, &len);
         }
-        editorInsertRow(&E, E.numrows, line, linelen);
+        close(fd);
+
+        len = editorStripCarriageReturns(buf, len);
+        editorLoadRows(&E, buf, len, false);
     }
-    free(line);
-    fclose(fp);
+
     if (E.line_numbers){
         E.last_row_digits = count_digits(E.numrows) + 1;
     }
@@ -467,6 +583,8 @@ void editorOpen(char *filename){
     E.dirty = 0;
 }
 
+// the pieces are written straight out of the piece table into a sibling file that is
+// synced and renamed over the original, so a crash leaves either the old or the new file
 void editorSave(){
     if (E.filename == NULL){
         E.filename = editorPrompt("Save as: %s", NULL);
@@ -477,32 +595,65 @@ void editorSave(){
         editorSelectSyntaxHighlight(&E);
     }
 
+    double start = perfNow();
 
-    int len;
-    char *buf = editorRowsToString(&len);
+    size_t len = ptLength(&E.pt);
+    // the temporary file goes next to the file a symlink points at, so the link survives the rename
+    char *target = realpath(E.filename, NULL);
+    const char *path = target ? target : E.filename;
+    int namelen = strlen(path);
+    char *tmpname = malloc(namelen + 8);
+    if (tmpname == NULL){
+        die("editor save");
+    }
+    snprintf(tmpname, namelen + 8, "%s.XXXXXX", path);
 
-    int fd = open(E.filename, O_RDWR | O_CREAT, 0644);
+    int fd = mkstemp(tmpname);
     if (fd == -1){
         editorSetStatusMessage(&E, "Can't save! I/O error: %s", strerror(errno));
-        free(buf);
+        free(tmpname);
+        free(target);
         return;
     }
-    if (ftruncate(fd, len) == -1){
-        editorSetStatusMessage(&E, "Can't save! I/O error: %s", strerror(errno));
-        close(fd);
-        free(buf);
-        return;
+
+    struct stat st;
+    if (stat(path, &st) == 0){
+        // chown first, it may clear the setuid and setgid bits
+        if (fchown(fd, st.st_uid, st.st_gid) == -1){
+            fchown(fd, -1, st.st_gid);
+        }
+        fchmod(fd, st.st_mode & 07777);
+    }else{
+        fchmod(fd, 0644);
     }
 
-    if (write(fd, buf, len) != len){
-        editorSetStatusMessage(&E, "Can't save! I/O error: %s", strerror(errno));
-        close(fd);
-        free(buf);
+    saveBatch batch;
+    batch.fd = fd;
+    batch.count = 0;
+    int err = 0;
+    if (ptForEach(&E.pt, editorBatchPiece, &batch) || editorFlushBatch(&batch) == -1 || fsync(fd) == -1){
+        err = errno;
+    }
+    // close releases the descriptor even when it reports an error
+    if (close(fd) == -1 && err == 0){
+        err = errno;
+    }
+    if (err == 0 && rename(tmpname, path) == -1){
+        err = errno;
+    }
+    if (err){
+        editorSetStatusMessage(&E, "Can't save! I/O error: %s", strerror(err));
+        unlink(tmpname);
+        free(tmpname);
+        free(target);
         return;
     }
-    editorSetStatusMessage(&E, "%d bytes written to disk", len);
-    close(fd);
-    free(buf);
+    editorSyncDir(path);
+
+    double us = perfNow() - start;
+    editorSetStatusMessage(&E, "%zu bytes written to disk (%.1f MB/s)", len, us > 0 ? len / us : 0.0);
+    free(tmpname);
+    free(target);
     E.dirty = 0;
 }
 
@@ -516,7 +667,8 @@ void editorFindCallback(char *query, int key){
     static char *saved_hl = NULL;
 
     if (saved_hl){
-        memcpy(E.row[saved_hl_line].hl, saved_hl, E.row[saved_hl_line].rsize);
+        erow *row = editorRenderedRowAt(&E, saved_hl_line);
+        memcpy(row->hl, saved_hl, row->render_len);
         free(saved_hl);
         saved_hl = NULL;
     }
@@ -550,7 +702,23 @@ void editorFindCallback(char *query, int key){
             current = 0;
         }
 
-        erow *row = &E.row[current];
+        // long rows are only rendered around the viewport, so they are searched in chars
+        // and the match is not painted
+        erow *row = editorRowAt(&E, current);
+        if (editorRowIsLong(row)){
+            char *chars = editorRowChars(row);
+            char *match = memmem(chars, row->size, query, strlen(query));
+            if (match){
+                last_match = current;
+                E.cy = current;
+                E.cx = match - chars + E.last_row_digits;
+                E.rowoff = E.numrows;
+                break;
+            }
+            continue;
+        }
+
+        editorRowRender(&E, row);
         char *match = strstr(row->render, query);
         if (match) {
             last_match = current;
@@ -559,8 +727,8 @@ void editorFindCallback(char *query, int key){
             E.rowoff = E.numrows;
 
             saved_hl_line = current;
-            saved_hl = malloc(row->rsize);
-            memcpy(saved_hl, row->hl, row->rsize);
+            saved_hl = malloc(row->render_len);
+            memcpy(saved_hl, row->hl, row->render_len);
             memset(&row->hl[match - row->render], HL_MATCH, strlen(query));
             break;
         }
@@ -586,13 +754,14 @@ void editorFind(){
 }
 
 void editorFindInRow(int c, int dir){
-    if (E.cy < 0 || E.cy > E.numrows){
+    if (E.cy < 0 || E.cy >= E.numrows){
         return;
     }
-    erow row = E.row[E.cy];
+    erow *row = editorRowAt(&E, E.cy);
+    char *chars = editorRowChars(row);
     if (dir > 0){
-        for (int i = editor_cx_to_index(&E) + 1; i < row.size; i++){
-            if (row.chars[i] == c){
+        for (int i = editor_cx_to_index(&E) + 1; i < row->size; i++){
+            if (chars[i] == c){
                 E.cx = E.last_row_digits + i;
                 E.last_cx = E.cx;
                 return;
@@ -601,7 +770,7 @@ void editorFindInRow(int c, int dir){
         return;
     }
     for (int i = editor_cx_to_index(&E) - 1; i > 0; i--){
-        if (row.chars[i] == c){
+        if (chars[i] == c){
             E.cx = E.last_row_digits + i;
             E.last_cx = E.cx;
             return;
@@ -609,26 +778,6 @@ void editorFindInRow(int c, int dir){
     }
 }
 
-/*** append buffer ***/
-
-#define ABUF_INIT {NULL, 0}
-
-void abAppend(struct abuf *ab, const char *s, int len){
-    char *new = realloc(ab->b, ab->len + len);
-    
-    if (new == NULL){
-        return;
-    }
-
-    memcpy(&new[ab->len], s, len);
-    ab->b = new;
-    ab->len += len;
-}
-
-void abFree(struct abuf *ab){
-    free(ab->b);
-}
-
 /*** input ***/
 
 char *editorPrompt(char *prompt, void (*callback)(char *, int)) {
@@ -674,14 +823,14 @@ char *editorPrompt(char *prompt, void (*callback)(char *, int)) {
 }
 
 void editorMoveCursor(int key, int amount){
-    erow *row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
+    erow *row = (E.cy >= E.numrows) ? NULL : editorRowAt(&E, E.cy);
 
     switch (key) {
         case ARROW_UP:{
             if (E.cy != 0){
                 E.cy = max(E.cy - amount, 0);
                 E.cx = E.last_cx;
-                if (editor_cx_to_index(&E) >= E.row[E.cy].size){
+                if (editor_cx_to_index(&E) >= editorRowAt(&E, E.cy)->size){
                     E.cx = row->size + E.last_row_digits;
                 }
             }
@@ -691,7 +840,7 @@ void editorMoveCursor(int key, int amount){
             if (E.cy < E.numrows - 1){
                 E.cy = min(E.cy + amount, E.numrows - 1);
                 E.cx = E.last_cx;
-                if (editor_cx_to_index(&E) >= E.row[E.cy].size){
+                if (editor_cx_to_index(&E) >= editorRowAt(&E, E.cy)->size){
                     E.cx = row->size + E.last_row_digits;
                 }
             }
@@ -702,7 +851,7 @@ void editorMoveCursor(int key, int amount){
                 E.cx = max(E.cx - amount, E.last_row_digits);
                 E.last_cx = E.cx;
             }else if (E.cy > 0){
-                E.cx = E.row[--E.cy].size + E.last_row_digits;
+                E.cx = editorRowAt(&E, --E.cy)->size + E.last_row_digits;
                 E.last_cx = E.cx;
             }
             break;
@@ -720,7 +869,7 @@ void editorMoveCursor(int key, int amount){
         }
     }
 
-    row = (E.cy >= E.numrows) ? NULL : &E.row[E.cy];
+    row = (E.cy >= E.numrows) ? NULL : editorRowAt(&E, E.cy);
     int rowlen = row ? row->size : 0;
     if (editor_cx_to_index(&E) > rowlen){
         E.cx = rowlen + E.last_row_digits;
@@ -728,20 +877,21 @@ void editorMoveCursor(int key, int amount){
 }
 
 void editorMoveCursorCommand(int dir){
-    if (E.cy < 0 || E.cy > E.numrows){
+    if (E.cy < 0 || E.cy >= E.numrows){
         return;
     }
-    erow row = E.row[E.cy];
+    erow *row = editorRowAt(&E, E.cy);
+    char *chars = editorRowChars(row);
     if (dir < 0){
-        for (int i = 0; i < row.size; i++){
-            if (!isspace(row.chars[i])){
+        for (int i = 0; i < row->size; i++){
+            if (!isspace(chars[i])){
                 E.cx = i + E.last_row_digits;
                 return;
             }
         }
     }
-    for (int i = row.size; i > 0; i--){
-        if (!isspace(row.chars[i])){
+    for (int i = row->size - 1; i > 0; i--){
+        if (!isspace(chars[i])){
             E.cx = i + E.last_row_digits;
             return;
         }
@@ -902,7 +1052,17 @@ void mode_function_normal(){
             break;
         }
 
-        case CTRL_KEY('l'):
+        case CTRL_KEY('l'):{
+            E.full_redraw = true;
+            break;
+        }
+
+        case CTRL_KEY('p'):{
+            E.perf.enabled = !E.perf.enabled;
+            editorSetStatusMessage(&E, "perf overlay %s", E.perf.enabled ? "on" : "off");
+            break;
+        }
+
         case '\x1b':{
             break;
         }
@@ -925,21 +1085,7 @@ void mode_function_normal(){
 
         case PAGE_UP:
         case PAGE_DOWN:{
-            if (c == PAGE_UP) {
-                E.cy = E.rowoff;
-            } else if (c == PAGE_DOWN) {
-                E.cy = E.rowoff + E.screenrows - 1;
-                if (E.cy > E.numrows){
-                    E.cy = E.numrows;
-                }
-            }
-
-            {
-                int times = E.screenrows;
-                while (times--){
-                    editorMoveCursor(c == PAGE_UP ? ARROW_UP : ARROW_DOWN, 1);
-                }
-            }
+            editorScrollPage(&E, c == PAGE_UP ? -1 : 1);
             break;
         }
 
@@ -1042,27 +1188,14 @@ void mode_function_insert(){
         }
         case END_KEY:{
             if (E.cy < E.numrows){
-                E.cx = max(E.row[E.cy].size, E.last_row_digits);
+                E.cx = max(editorRowAt(&E, E.cy)->size, E.last_row_digits);
             }
             break;
         }
 
         case PAGE_UP:
         case PAGE_DOWN:{
-            if (c == PAGE_UP) {
-                E.cy = E.rowoff;
-            } else if (c == PAGE_DOWN) {
-                E.cy = E.rowoff + E.screenrows - 1;
-                if (E.cy > E.numrows){
-                    E.cy = E.numrows;
-                }
-            }
-
-            {
-                int times = E.screenrows;
-                while (times--)
-                    editorMoveCursor(c == PAGE_UP ? ARROW_UP : ARROW_DOWN, 1);
-            }
+            editorScrollPage(&E, c == PAGE_UP ? -1 : 1);
             break;
         }
 
@@ -1206,28 +1339,14 @@ void mode_function_visual(){
         case END_KEY:
         case '$':{
             if (E.cy < E.numrows){
-                E.cx = E.row[E.cy].size + E.last_row_digits;
+                E.cx = editorRowAt(&E, E.cy)->size + E.last_row_digits;
             }
             break;
         }
 
         case PAGE_UP:
         case PAGE_DOWN:{
-            if (c == PAGE_UP) {
-                E.cy = E.rowoff;
-            } else if (c == PAGE_DOWN) {
-                E.cy = E.rowoff + E.screenrows - 1;
-                if (E.cy > E.numrows){
-                    E.cy = E.numrows;
-                }
-            }
-
-            {
-                int times = E.screenrows;
-                while (times--){
-                    editorMoveCursor(c == PAGE_UP ? ARROW_UP : ARROW_DOWN, 1);
-                }
-            }
+            editorScrollPage(&E, c == PAGE_UP ? -1 : 1);
             break;
         }
 
@@ -1251,15 +1370,36 @@ void editorProccessKeyPress(){
     return E.mode_functions[E.mode]();
 }
 
+static bool editorInputPending(){
+    struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+    return poll(&pfd, 1, 0) > 0;
+}
+
+// handles one key and then whatever is already queued, so a paste or key repeat
+// is drawn once; max_latency caps how long the screen may fall behind
+void editorProcessInput(){
+    editorProccessKeyPress();
+
+    double start = perfNow();
+    while (editorInputPending() && perfNow() - start < E.max_latency * 1e3){
+        editorProccessKeyPress();
+    }
+}
+
 /*** init ***/
 
-void initEditor(){
+void initEditor(int screenrows, int screencols){
     E.cy = E.numrows = E.rowoff = E.cx = E.coloff = E.rx = E.last_cx = E.dirty = E.last_row_digits = E.vhl_start = E.vhl_row = 0;
     E.quit_times = E.quit_times_curr = 3;
     E.mode = NORMAL;
-    E.row = NULL;
     E.filename = NULL;
     E.syntax = NULL;
+    E.wrapoff = E.lineoff = 0;
+    E.screen_prev = E.screen_next = NULL;
+    E.frame = (struct abuf)ABUF_INIT;
+    E.perf = (perfStats){0};
+    E.full_redraw = true;
+    E.sync_output = false;
     E.statusmsg[0] = '\0';
     E.statusmsg_time = 0;
     E.mode_functions[NORMAL] = mode_function_normal;
@@ -1271,10 +1411,8 @@ void initEditor(){
         die("unkown os");
     }
     E.os_type = os;
-    if (getWindowSize(&E.screenrows, &E.screencolsBase) == -1){
-        die("getWindowSize");
-    }
-    E.screenrows -= 2;
+    E.screenrows = screenrows - 2;
+    E.screencolsBase = screencols;
     int res = init_kilo_config(&E);
     if (res == 0){
         die("init");
@@ -1282,10 +1420,16 @@ void initEditor(){
     E.screencols = E.screencolsBase - E.last_row_digits;
 }
 
+#ifndef KILO_BENCH
 int main(int argc, char *argv[]){
     enableRawMode();
     //enableMouse();
-    initEditor();
+    int rows, cols;
+    if (getWindowSize(&rows, &cols) == -1){
+        die("getWindowSize");
+    }
+    initEditor(rows, cols);
+    E.sync_output = getSyncOutputSupport();
     if (argc > 1){
         editorOpen(argv[1]);
     }
@@ -1294,10 +1438,12 @@ int main(int argc, char *argv[]){
     }
 
     editorSetStatusMessage(&E, "HELP: Ctrl-S = save | Ctrl-Q = quit | Ctrl-F = find");
+    editorStartSyntaxWorker(&E);
 
     while (1) {
         editorRefreshScreen(&E);
-        editorProccessKeyPress();
+        editorProcessInput();
     }
     return 0;
 }
+#endif
@@ -0,0 +1,43 @@
+#include "perf.h"
+#include <time.h>
+
+double perfNow(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// syntax time is accumulated between frames and charged to the frame that follows it
+void perfRecordFrame(perfStats *perf, double frame_us, size_t bytes, int rows_redrawn){
+    perf->frame_us = frame_us;
+    perf->bytes = bytes;
+    perf->rows_redrawn = rows_redrawn;
+    perf->syntax_us = perf->syntax_pending_us;
+    perf->syntax_pending_us = 0;
+
+    perf->samples[perf->next] = frame_us;
+    perf->next = (perf->next + 1) % PERF_SAMPLES;
+    if (perf->nsamples < PERF_SAMPLES){
+        perf->nsamples++;
+    }
+}
+
+// the window is small, so a copy plus insertion sort is cheaper than keeping it ordered
+double perfPercentile(perfStats *perf, double p){
+    if (perf->nsamples == 0){
+        return 0;
+    }
+
+    double sorted[PERF_SAMPLES];
+    int n = perf->nsamples;
+    for (int i = 0; i < n; i++){
+        double v = perf->samples[i];
+        int j = i;
+        while (j > 0 && sorted[j - 1] > v){
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return sorted[(int)(p * (n - 1) + 0.5)];
+}
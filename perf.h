@@ -0,0 +1,25 @@
+#ifndef KILO_PERF_H
+#define KILO_PERF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PERF_SAMPLES 256
+
+typedef struct perfStats{
+    bool enabled;
+    double frame_us;
+    double syntax_us;
+    double syntax_pending_us;
+    size_t bytes;
+    int rows_redrawn;
+    double samples[PERF_SAMPLES];
+    int nsamples;
+    int next;
+}perfStats;
+
+double perfNow();
+void perfRecordFrame(perfStats *perf, double frame_us, size_t bytes, int rows_redrawn);
+double perfPercentile(perfStats *perf, double p);
+
+#endif
@@ -0,0 +1,292 @@
+#include "piece_table.h"
+#include "utils.h"
+#include <sys/mman.h>
+
+static unsigned int pt_seed = 2463534242u;
+
+static unsigned int ptRandom(){
+    pt_seed ^= pt_seed << 13;
+    pt_seed ^= pt_seed >> 17;
+    pt_seed ^= pt_seed << 5;
+    return pt_seed;
+}
+
+static size_t ptCountNewlines(const char *s, size_t len){
+    size_t count = 0;
+    const char *end = s + len;
+
+    while (s < end && (s = memchr(s, '\n', end - s)) != NULL){
+        count++;
+        s++;
+    }
+
+    return count;
+}
+
+static void ptUpdate(ptNode *node){
+    node->sub_len = node->len;
+    node->sub_newlines = node->newlines;
+    if (node->left){
+        node->sub_len += node->left->sub_len;
+        node->sub_newlines += node->left->sub_newlines;
+    }
+    if (node->right){
+        node->sub_len += node->right->sub_len;
+        node->sub_newlines += node->right->sub_newlines;
+    }
+}
+
+static ptNode *ptNewNode(const char *start, size_t len){
+    ptNode *node = malloc(sizeof(ptNode));
+    if (node == NULL){
+        die("piece table node");
+    }
+
+    node->start = start;
+    node->len = len;
+    node->newlines = ptCountNewlines(start, len);
+    node->priority = ptRandom();
+    node->left = NULL;
+    node->right = NULL;
+    ptUpdate(node);
+
+    return node;
+}
+
+static void ptFreeNode(ptNode *node){
+    if (node == NULL){
+        return;
+    }
+    ptFreeNode(node->left);
+    ptFreeNode(node->right);
+    free(node);
+}
+
+static ptNode *ptMerge(ptNode *a, ptNode *b){
+    if (a == NULL){
+        return b;
+    }
+    if (b == NULL){
+        return a;
+    }
+
+    if (a->priority > b->priority){
+        a->right = ptMerge(a->right, b);
+        ptUpdate(a);
+        return a;
+    }
+
+    b->left = ptMerge(a, b->left);
+    ptUpdate(b);
+    return b;
+}
+
+// splits the tree so that *left holds the first off bytes, cutting a piece in two if needed
+static void ptSplit(ptNode *node, size_t off, ptNode **left, ptNode **right){
+    if (node == NULL){
+        *left = NULL;
+        *right = NULL;
+        return;
+    }
+
+    size_t left_len = node->left ? node->left->sub_len : 0;
+    if (off <= left_len){
+        ptSplit(node->left, off, left, &node->left);
+        ptUpdate(node);
+        *right = node;
+        return;
+    }
+
+    if (off >= left_len + node->len){
+        ptSplit(node->right, off - left_len - node->len, &node->right, right);
+        ptUpdate(node);
+        *left = node;
+        return;
+    }
+
+    size_t cut = off - left_len;
+    ptNode *tail = ptNewNode(node->start + cut, node->len - cut);
+    ptNode *right_sub = node->right;
+
+    node->len = cut;
+    node->newlines -= tail->newlines;
+    node->right = NULL;
+    ptUpdate(node);
+
+    *left = node;
+    *right = ptMerge(tail, right_sub);
+}
+
+static ptNode *ptRightmost(ptNode *node){
+    while (node && node->right){
+        node = node->right;
+    }
+    return node;
+}
+
+static void ptUpdateRightSpine(ptNode *node){
+    if (node == NULL){
+        return;
+    }
+    ptUpdateRightSpine(node->right);
+    ptUpdate(node);
+}
+
+static char *ptAddAlloc(pieceTable *pt, size_t len){
+    ptChunk *chunk = pt->add;
+    if (chunk == NULL || chunk->cap - chunk->used < len){
+        size_t cap = len > PT_CHUNK_SIZE ? len : PT_CHUNK_SIZE;
+        chunk = malloc(sizeof(ptChunk) + cap);
+        if (chunk == NULL){
+            die("piece table chunk");
+        }
+        chunk->next = pt->add;
+        chunk->used = 0;
+        chunk->cap = cap;
+        pt->add = chunk;
+    }
+
+    char *dst = &chunk->data[chunk->used];
+    chunk->used += len;
+    return dst;
+}
+
+void ptLoad(pieceTable *pt, char *buf, size_t len){
+    ptFree(pt);
+    pt->orig = buf;
+    pt->orig_len = len;
+
+    for (size_t done = 0; done < len; done += PT_PIECE_MAX){
+        size_t n = len - done < PT_PIECE_MAX ? len - done : PT_PIECE_MAX;
+        pt->root = ptMerge(pt->root, ptNewNode(&buf[done], n));
+    }
+}
+
+// the original text stays a read-only mapping of the file; ptFree unmaps it
+void ptLoadMapped(pieceTable *pt, char *map, size_t len){
+    ptLoad(pt, map, len);
+    pt->mapped = true;
+}
+
+// returns where the copy of s lives in the add buffer; it stays put until ptFree
+const char *ptInsert(pieceTable *pt, size_t off, const char *s, size_t len){
+    if (len == 0){
+        return NULL;
+    }
+
+    ptNode *left, *right;
+    ptSplit(pt->root, off, &left, &right);
+
+    ptNode *last = ptRightmost(left);
+    ptChunk *chunk = pt->add;
+    char *dst;
+    if (last && chunk && last->start + last->len == &chunk->data[chunk->used] &&
+        chunk->cap - chunk->used >= len && last->len + len <= PT_PIECE_MAX){
+        dst = ptAddAlloc(pt, len);
+        memcpy(dst, s, len);
+        last->len += len;
+        last->newlines += ptCountNewlines(dst, len);
+        ptUpdateRightSpine(left);
+    }else{
+        dst = ptAddAlloc(pt, len);
+        memcpy(dst, s, len);
+        for (size_t done = 0; done < len; done += PT_PIECE_MAX){
+            size_t n = len - done < PT_PIECE_MAX ? len - done : PT_PIECE_MAX;
+            left = ptMerge(left, ptNewNode(&dst[done], n));
+        }
+    }
+
+    pt->root = ptMerge(left, right);
+    return dst;
+}
+
+void ptDelete(pieceTable *pt, size_t off, size_t len){
+    if (len == 0){
+        return;
+    }
+
+    ptNode *left, *mid, *right;
+    ptSplit(pt->root, off, &left, &right);
+    ptSplit(right, len, &mid, &right);
+    ptFreeNode(mid);
+    pt->root = ptMerge(left, right);
+}
+
+size_t ptLineStart(pieceTable *pt, size_t line){
+    if (line == 0){
+        return 0;
+    }
+
+    ptNode *node = pt->root;
+    size_t base = 0;
+    while (node){
+        size_t left_len = node->left ? node->left->sub_len : 0;
+        size_t left_newlines = node->left ? node->left->sub_newlines : 0;
+
+        if (line <= left_newlines){
+            node = node->left;
+            continue;
+        }
+
+        line -= left_newlines;
+        if (line <= node->newlines){
+            const char *p = node->start;
+            const char *end = node->start + node->len;
+            while (1){
+                p = memchr(p, '\n', end - p);
+                if (--line == 0){
+                    break;
+                }
+                p++;
+            }
+            return base + left_len + (p - node->start) + 1;
+        }
+
+        line -= node->newlines;
+        base += left_len + node->len;
+        node = node->right;
+    }
+
+    return base;
+}
+
+size_t ptLength(pieceTable *pt){
+    return pt->root ? pt->root->sub_len : 0;
+}
+
+static int ptForEachNode(ptNode *node, ptPieceFn fn, void *ctx){
+    if (node == NULL){
+        return 0;
+    }
+    if (ptForEachNode(node->left, fn, ctx)){
+        return 1;
+    }
+    if (fn(ctx, node->start, node->len)){
+        return 1;
+    }
+    return ptForEachNode(node->right, fn, ctx);
+}
+
+int ptForEach(pieceTable *pt, ptPieceFn fn, void *ctx){
+    return ptForEachNode(pt->root, fn, ctx);
+}
+
+void ptFree(pieceTable *pt){
+    ptFreeNode(pt->root);
+    pt->root = NULL;
+
+    while (pt->add){
+        ptChunk *next = pt->add->next;
+        free(pt->add);
+        pt->add = next;
+    }
+
+    if (pt->mapped){
+        munmap(pt->orig, pt->orig_len);
+    }else{
+        free(pt->orig);
+    }
+    pt->orig = NULL;
+    pt->mapped = false;
+    pt->orig_len = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef KILO_PIECE_TABLE_H
+#define KILO_PIECE_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PT_PIECE_MAX 16384
+#define PT_CHUNK_SIZE 65536
+
+typedef struct ptNode{
+    const char *start;
+    size_t len;
+    size_t newlines;
+    size_t sub_len;
+    size_t sub_newlines;
+    unsigned int priority;
+    struct ptNode *left;
+    struct ptNode *right;
+}ptNode;
+
+typedef struct ptChunk{
+    struct ptChunk *next;
+    size_t used;
+    size_t cap;
+    char data[];
+}ptChunk;
+
+typedef struct pieceTable{
+    char *orig;
+    size_t orig_len;
+    bool mapped;
+    ptChunk *add;
+    ptNode *root;
+}pieceTable;
+
+typedef int (*ptPieceFn)(void *ctx, const char *s, size_t len);
+
+void ptLoad(pieceTable *pt, char *buf, size_t len);
+void ptLoadMapped(pieceTable *pt, char *map, size_t len);
+const char *ptInsert(pieceTable *pt, size_t off, const char *s, size_t len);
+void ptDelete(pieceTable *pt, size_t off, size_t len);
+size_t ptLineStart(pieceTable *pt, size_t line);
+size_t ptLength(pieceTable *pt);
+int ptForEach(pieceTable *pt, ptPieceFn fn, void *ctx);
+void ptFree(pieceTable *pt);
+
+#endif
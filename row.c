@@ -1,120 +1,509 @@
 #include "row.h"
 #include "utils.h"
 
+static void editorRowSegments(erow *row, const char **seg, int *seglen){
+    if (row->gap){
+        gbSegments(row->gap, &seg[0], &seglen[0], &seg[1], &seglen[1]);
+        return;
+    }
+    seg[0] = row->chars;
+    seglen[0] = row->size;
+    seg[1] = NULL;
+    seglen[1] = 0;
+}
+
+// tabs[2k] is the chars index of the k-th tab, tabs[2k + 1] the render column right after it
+static void editorRowIndexTabs(editorConfig *config, erow *row){
+    if (row->tabs_valid){
+        return;
+    }
+
+    const char *seg[2];
+    int seglen[2];
+    editorRowSegments(row, seg, seglen);
+
+    int count = 0;
+    for (int s = 0; s < 2; s++){
+        const char *p = seg[s];
+        const char *end = seg[s] + seglen[s];
+        while (p < end && (p = memchr(p, '\t', end - p)) != NULL){
+            count++;
+            p++;
+        }
+    }
+
+    if (count > row->tabs_cap){
+        row->tabs = realloc(row->tabs, sizeof(int) * 2 * count);
+        if (row->tabs == NULL){
+            die("tab index");
+        }
+        row->tabs_cap = count;
+    }
+
+    int k = 0;
+    int cx = 0;
+    int rx = 0;
+    for (int s = 0; s < 2; s++){
+        const char *p = seg[s];
+        const char *end = seg[s] + seglen[s];
+        while (p < end && (p = memchr(p, '\t', end - p)) != NULL){
+            int at = cx + (p - seg[s]);
+            int prev = k > 0 ? row->tabs[2*k - 2] + 1 : 0;
+            rx += at - prev;
+            rx += (*config).indent_amount - (rx % (*config).indent_amount);
+            row->tabs[2*k] = at;
+            row->tabs[2*k + 1] = rx;
+            k++;
+            p++;
+        }
+        cx += seglen[s];
+    }
+
+    row->ntabs = count;
+    row->tabs_valid = true;
+}
+
+// number of tabs before chars index cx
+static int editorRowTabsBefore(erow *row, int cx){
+    int lo = 0;
+    int hi = row->ntabs;
+    while (lo < hi){
+        int mid = (lo + hi) / 2;
+        if (row->tabs[2*mid] < cx){
+            lo = mid + 1;
+        }else{
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int editorRowRenderCol(erow *row, int cx){
+    int k = editorRowTabsBefore(row, cx);
+    if (k == 0){
+        return cx;
+    }
+    return row->tabs[2*k - 1] + (cx - row->tabs[2*k - 2] - 1);
+}
+
 int editorRowCxToRx(editorConfig *config, erow *row, int cx) {
-    int rx = config->last_row_digits;
-    int j;
-    for (j = 0; j < cx; j++) {
-        if (row->chars[j] == '\t'){
-            rx += ((*config).indent_amount - 1) - (rx % (*config).indent_amount);
+    editorRowIndexTabs(config, row);
+    // the cursor may sit inside the gutter or past the end of the row
+    if (cx < 0){
+        cx = 0;
+    }
+    if (cx > row->size){
+        cx = row->size;
+    }
+    return editorRowRenderCol(row, cx) + (*config).last_row_digits;
+}
+
+// number of screen lines the row takes with soft wrap, cached per text width
+int editorRowWrapLines(editorConfig *config, erow *row){
+    int cols = (*config).screencols;
+    if (row->wrap_cols != cols){
+        editorRowIndexTabs(config, row);
+        int width = editorRowRenderCol(row, row->size);
+        int lines = cols > 0 && width > 0 ? (width + cols - 1) / cols : 1;
+        if (lines != row->wrap_lines){
+            rtSetLines(row, lines);
         }
-        rx++;
+        row->wrap_cols = cols;
     }
-    return rx;
+    return row->wrap_lines;
 }
 
 int editorRowRxToCx(editorConfig *config, erow *row, int rx){
-    int cur_rx = 0;
-    int cx;
+    editorRowIndexTabs(config, row);
 
-    for (cx = 0; cx < row->size; cx++){
-        if (row->chars[cx] == '\t'){
-            cur_rx += ((*config).indent_amount - 1) - (cur_rx % (*config).indent_amount);
+    // first tab that ends past rx
+    int lo = 0;
+    int hi = row->ntabs;
+    while (lo < hi){
+        int mid = (lo + hi) / 2;
+        if (row->tabs[2*mid + 1] <= rx){
+            lo = mid + 1;
+        }else{
+            hi = mid;
         }
-        cur_rx++;
     }
 
-    if (cur_rx > rx){
-        return cx + (*config).last_row_digits;
+    int cx;
+    if (lo < row->ntabs && editorRowRenderCol(row, row->tabs[2*lo]) <= rx){
+        cx = row->tabs[2*lo];
+    }else if (lo > 0){
+        cx = row->tabs[2*lo - 2] + 1 + (rx - row->tabs[2*lo - 1]);
+    }else{
+        cx = rx;
     }
 
+    if (cx > row->size){
+        cx = row->size;
+    }
     return cx + (*config).last_row_digits;
 }
 
-void editorUpdateRow(editorConfig *config, erow *row){
+static void editorRenderRow(editorConfig *config, erow *row){
+    const char *seg[2];
+    int seglen[2];
+    editorRowSegments(row, seg, seglen);
+
     int tabs = 0;
     int j;
-    for (j = 0; j < row->size; j++){
-        if (row->chars[j] == '\t'){
+    for (int s = 0; s < 2; s++){
+        for (j = 0; j < seglen[s]; j++){
+            if (seg[s][j] == '\t'){
+                tabs++;
+            }
+        }
+    }
+
+    // render and hl share one block: render + NUL, then hl
+    int cap = row->size + tabs*((*config).indent_amount - 1);
+    row->render = malloc(cap * 2 + 1);
+    if (row->render == NULL){
+        die("render row");
+    }
+
+    int idx = 0;
+    for (int s = 0; s < 2; s++){
+        for (j = 0; j < seglen[s]; j++){
+            if (seg[s][j] == '\t') {
+                row->render[idx++] = ' ';
+                while (idx % (*config).indent_amount != 0) row->render[idx++] = ' ';
+            } else {
+                row->render[idx++] = seg[s][j];
+            }
+        }
+    }
+
+    row->render[idx] = '\0';
+    row->rsize = idx;
+    row->render_off = 0;
+    row->render_len = idx;
+    row->render_cx = 0;
+
+    row->hl = (unsigned char *)&row->render[cap + 1];
+    row->hl_entry = -1;
+}
+
+bool editorRowIsLong(erow *row){
+    return row->size > ROW_LONG_LINE;
+}
+
+// copies chars [from, from + len) clipped to the row, reading around an open gap
+int editorRowCopyChars(erow *row, int from, int len, char *out){
+    const char *seg[2];
+    int seglen[2];
+    editorRowSegments(row, seg, seglen);
+
+    int copied = 0;
+    for (int s = 0; s < 2 && len > 0; s++){
+        if (from >= seglen[s]){
+            from -= seglen[s];
+            continue;
+        }
+        int n = min(len, seglen[s] - from);
+        memcpy(out + copied, seg[s] + from, n);
+        copied += n;
+        len -= n;
+        from = 0;
+    }
+    return copied;
+}
+
+// renders only render columns around [from, from + len); the window starts on a checkpoint
+// boundary so highlighting can resume there instead of at the start of the row
+static void editorRenderWindow(editorConfig *config, erow *row, int from, int len){
+    editorRowIndexTabs(config, row);
+    row->rsize = editorRowRenderCol(row, row->size);
+
+    int start_rx = max(from - ROW_WINDOW_MARGIN, 0);
+    int end_rx = min(from + len + ROW_WINDOW_MARGIN, row->rsize);
+    int start_cx = editorRowRxToCx(config, row, start_rx) - (*config).last_row_digits;
+    start_cx -= start_cx % ROW_CHECKPOINT_CHARS;
+    int end_cx = editorRowRxToCx(config, row, end_rx) - (*config).last_row_digits;
+    end_cx = min(end_cx + ROW_CHECKPOINT_SLACK, row->size);
+
+    int nchars = end_cx - start_cx;
+    char *chars = malloc(nchars + 1);
+    if (chars == NULL){
+        die("render window");
+    }
+    editorRowCopyChars(row, start_cx, nchars, chars);
+
+    int tabs = 0;
+    for (int j = 0; j < nchars; j++){
+        if (chars[j] == '\t'){
             tabs++;
         }
     }
 
-    free(row->render);
-    row->render = malloc(row->size + tabs*((*config).indent_amount - 1) + 1);
+    int cap = nchars + tabs*((*config).indent_amount - 1);
+    row->render = malloc(cap * 2 + 1);
+    if (row->render == NULL){
+        die("render window");
+    }
 
+    // tab stops stay relative to the start of the row
+    int off = editorRowRenderCol(row, start_cx);
     int idx = 0;
-    for (j = 0; j < row->size; j++){
-        if (row->chars[j] == '\t') {
+    for (int j = 0; j < nchars; j++){
+        if (chars[j] == '\t') {
             row->render[idx++] = ' ';
-            while (idx % (*config).indent_amount != 0) row->render[idx++] = ' ';
+            while ((off + idx) % (*config).indent_amount != 0) row->render[idx++] = ' ';
         } else {
-            row->render[idx++] = row->chars[j];
+            row->render[idx++] = chars[j];
         }
     }
+    free(chars);
 
     row->render[idx] = '\0';
-    row->rsize = idx;
+    row->render_off = off;
+    row->render_len = idx;
+    row->render_cx = start_cx;
 
-    if (row->vhl != NULL){
-        free(row->vhl);
+    row->hl = (unsigned char *)&row->render[cap + 1];
+    row->hl_entry = -1;
+}
+
+static void editorRowUnlink(editorConfig *config, erow *row){
+    if (row->lru_prev){
+        row->lru_prev->lru_next = row->lru_next;
+    }else{
+        (*config).lru_head = row->lru_next;
     }
-    row->vhl = (unsigned char *)malloc(sizeof(char) * row->rsize);
-    if (row->vhl == NULL){
-        die("update row");
+    if (row->lru_next){
+        row->lru_next->lru_prev = row->lru_prev;
+    }else{
+        (*config).lru_tail = row->lru_prev;
     }
-    memset(row->vhl, VHL_NORMAL, row->rsize);
-    editorUpdateSyntax(config, row);
+    row->lru_prev = NULL;
+    row->lru_next = NULL;
+    (*config).lru_count--;
 }
 
-void editorInsertRow(editorConfig *config, int at, char *s, size_t len){
-    if (at < 0 || at > (*config).numrows) {
+static void editorRowPushFront(editorConfig *config, erow *row){
+    row->lru_prev = NULL;
+    row->lru_next = (*config).lru_head;
+    if ((*config).lru_head){
+        (*config).lru_head->lru_prev = row;
+    }else{
+        (*config).lru_tail = row;
+    }
+    (*config).lru_head = row;
+    (*config).lru_count++;
+}
+
+static void editorRowCollapse(editorConfig *config, erow *row){
+    if (row->render == NULL){
         return;
     }
-    (*config).row = realloc((*config).row, sizeof(erow) * ((*config).numrows + 1));
-    if ((*config).row == NULL){
-        die("editore append row");
+    editorRowUnlink(config, row);
+
+    free(row->render);
+    row->render = NULL;
+    row->hl = NULL;
+    row->rsize = 0;
+    row->hl_entry = -1;
+}
+
+static void editorTrimRows(editorConfig *config){
+    while ((*config).lru_count > ROW_CACHE_MAX){
+        editorRowCollapse(config, (*config).lru_tail);
+    }
+}
+
+erow *editorRowRender(editorConfig *config, erow *row){
+    return editorRowRenderRange(config, row, (*config).coloff, (*config).screencols);
+}
+
+// makes sure render columns [from, from + len) are rendered and highlighted
+erow *editorRowRenderRange(editorConfig *config, erow *row, int from, int len){
+    if (row->render && editorRowIsLong(row)){
+        int end = min(from + len, row->rsize);
+        if (from < row->render_off || end > row->render_off + row->render_len){
+            editorRowCollapse(config, row);
+        }
+    }
+
+    if (row->render == NULL){
+        if (editorRowIsLong(row)){
+            editorRenderWindow(config, row, from, len);
+        }else{
+            editorRenderRow(config, row);
+        }
+    }else{
+        editorRowUnlink(config, row);
     }
-    memmove(&(*config).row[at + 1], &(*config).row[at], sizeof(erow) * ((*config).numrows - at));
+    editorRowPushFront(config, row);
+    editorUpdateSyntax(config, row);
+    editorTrimRows(config);
 
-    for (int j = at + 1; j <= (*config).numrows; j++) {
-        (*config).row[j].idx++;
+    return row;
+}
+
+erow *editorRenderedRowAt(editorConfig *config, int at){
+    erow *row = editorRowAt(config, at);
+    if (row == NULL){
+        return NULL;
     }
+    return editorRowRender(config, row);
+}
 
-    (*config).row[at].idx = at;
+void editorUpdateRow(editorConfig *config, erow *row){
+    row->tabs_valid = false;
+    row->wrap_cols = 0;
+    row->ncheckpoints = 0;
+    row->hl_scan_entry = -1;
+    row->hl_version = ++(*config).hl_versions;
+    editorRowCollapse(config, row);
+    editorInvalidateSyntax(config, rtIndex(row));
+}
+
+char *editorRowChars(erow *row){
+    if (row->gap && row->gap_dirty){
+        char *chars = row->owned ? realloc(row->chars, row->size + 1) : malloc(row->size + 1);
+        if (chars == NULL){
+            die("row chars");
+        }
+        gbCopy(row->gap, chars);
+        chars[row->size] = '\0';
+        row->chars = chars;
+        row->owned = true;
+        row->gap_dirty = false;
+    }
+    return row->chars;
+}
 
-    (*config).row[at].size = len;
-    (*config).row[at].chars = malloc(len + 1);
-    if ((*config).row[at].chars == NULL){
-        die("editore append row");
+static void editorRowCloseGap(editorConfig *config, erow *row){
+    editorRowChars(row);
+    gbFree(row->gap);
+    row->gap = NULL;
+    if ((*config).gap_row == row){
+        (*config).gap_row = NULL;
+    }
+}
+
+static void editorRowOpenGap(editorConfig *config, erow *row){
+    if (row->gap){
+        return;
     }
+    if ((*config).gap_row){
+        editorRowCloseGap(config, (*config).gap_row);
+    }
+    row->gap = gbNew(row->chars, row->size);
+    row->gap_dirty = false;
+    (*config).gap_row = row;
+}
 
-    memcpy((*config).row[at].chars, s, len);
-    (*config).row[at].chars[len] = '\0';
+erow *editorRowAt(editorConfig *config, int at){
+    return rtGet(&(*config).rows, at);
+}
 
-    (*config).row[at].rsize = 0;
-    (*config).row[at].render = NULL;
-    (*config).row[at].hl = NULL;
-    (*config).row[at].vhl = NULL;
-    (*config).row[at].hl_open_comment = 0;
+static size_t editorRowOffset(editorConfig *config, erow *row){
+    return ptLineStart(&(*config).pt, rtIndex(row));
+}
 
-    editorUpdateRow(config, &(*config).row[at]);
+static void editorRowOwn(erow *row){
+    if (row->owned){
+        return;
+    }
 
-    (*config).numrows++;
+    char *chars = malloc(row->size + 1);
+    if (chars == NULL){
+        die("row own");
+    }
+    memcpy(chars, row->chars, row->size);
+    chars[row->size] = '\0';
+    row->chars = chars;
+    row->owned = true;
+}
+
+static void editorInitRow(erow *row, char *chars, size_t len, bool owned){
+    row->size = len;
+    row->chars = chars;
+    row->owned = owned;
+    row->rsize = 0;
+    row->render = NULL;
+    row->hl = NULL;
+    row->hl_open_comment = 0;
+    row->hl_scan_entry = -1;
+    row->hl_entry = -1;
+    row->lru_prev = NULL;
+    row->lru_next = NULL;
+    row->gap = NULL;
+    row->gap_dirty = false;
+    row->tabs = NULL;
+    row->ntabs = 0;
+    row->tabs_cap = 0;
+    row->tabs_valid = false;
+    row->checkpoints = NULL;
+    row->ncheckpoints = 0;
+    row->checkpoints_cap = 0;
+}
+
+static void editorUpdateRowDigits(editorConfig *config){
     if ((*config).line_numbers){
         (*config).last_row_digits = count_digits((*config).numrows) + 1;
         (*config).screencols = (*config).screencolsBase - (*config).last_row_digits;
     }else{
         (*config).last_row_digits = 0;
     }
+}
+
+void editorLoadRows(editorConfig *config, char *buf, size_t len, bool mapped){
+    if (mapped){
+        ptLoadMapped(&(*config).pt, buf, len);
+    }else{
+        ptLoad(&(*config).pt, buf, len);
+    }
+    if (len > 0 && buf[len - 1] != '\n'){
+        ptInsert(&(*config).pt, len, "\n", 1);
+    }
+
+    char *p = buf;
+    char *end = buf + len;
+    while (p < end){
+        char *nl = memchr(p, '\n', end - p);
+        if (nl == NULL){
+            nl = end;
+        }
+        erow *row = rtInsert(&(*config).rows, (*config).numrows++);
+        editorInitRow(row, p, nl - p, false);
+        row->hl_version = ++(*config).hl_versions;
+        p = nl + 1;
+    }
+    editorUpdateRowDigits(config);
+}
+
+void editorInsertRow(editorConfig *config, int at, char *s, size_t len){
+    if (at < 0 || at > (*config).numrows) {
+        return;
+    }
+
+    // the row is a view of its own copy in the piece table's add buffer
+    size_t off = ptLineStart(&(*config).pt, at);
+    const char *text = ptInsert(&(*config).pt, off, s, len);
+    const char *nl = ptInsert(&(*config).pt, off + len, "\n", 1);
+
+    erow *row = rtInsert(&(*config).rows, at);
+    editorInitRow(row, (char *)(len ? text : nl), len, false);
+    (*config).numrows++;
+    editorUpdateRow(config, row);
+
+    editorUpdateRowDigits(config);
     (*config).dirty++;
 }
 
 void editorFreeRow(erow *row){
-    free(row->chars);
+    if (row->owned){
+        free(row->chars);
+    }
+    gbFree(row->gap);
     free(row->render);
-    free(row->hl);
-    free(row->vhl);
+    free(row->tabs);
+    free(row->checkpoints);
 }
 
 void editorDelRow(editorConfig *config, int at){
@@ -122,41 +511,63 @@ void editorDelRow(editorConfig *config, int at){
         return;
     }
 
-    editorFreeRow(&(*config).row[at]);
-    memmove(&(*config).row[at], &(*config).row[at + 1], sizeof(erow) * ((*config).numrows - at - 1));
-
-    for (int j = at; j < (*config).numrows - 1; j++) {
-        (*config).row[j].idx--;
+    // invalidated while the row still holds its place, so the syntax chain is cut on current indexes
+    editorInvalidateSyntax(config, at);
+    erow *row = editorRowAt(config, at);
+    ptDelete(&(*config).pt, ptLineStart(&(*config).pt, at), row->size + 1);
+    if ((*config).gap_row == row){
+        (*config).gap_row = NULL;
+    }
+    if ((*config).hl_scan_last == row){
+        (*config).hl_scan_last = rtPrev(row);
     }
+    editorRowCollapse(config, row);
+    editorFreeRow(row);
+    rtDelete(&(*config).rows, at);
 
     (*config).numrows--;
-    if ((*config).line_numbers){
-        (*config).last_row_digits = count_digits((*config).numrows) + 1;
-        (*config).screencols = (*config).screencolsBase - (*config).last_row_digits;
-    }else{
-        (*config).last_row_digits = 0;
-    }
+    editorUpdateRowDigits(config);
     (*config).dirty++;
 }
 
-void editorRowInsertChar(editorConfig *config, erow *row, int at, int c){
+void editorRowInsertString(editorConfig *config, erow *row, int at, char *s, size_t len){
     if (at < 0 || at > row->size){
         at = row->size;
     }
-    row->chars = realloc(row->chars, row->size + 2);
-    memmove(&row->chars[at + 1], &row->chars[at], row->size - at + 1);
-    row->size++;
-    row->chars[at] = c;
+    ptInsert(&(*config).pt, editorRowOffset(config, row) + at, s, len);
+
+    editorRowOpenGap(config, row);
+    gbInsert(row->gap, at, s, len);
+    row->size += len;
+    row->gap_dirty = true;
 
     editorUpdateRow(config, row);
     (*config).dirty++;
 }
 
+void editorRowInsertChar(editorConfig *config, erow *row, int at, int c){
+    char ch = c;
+    editorRowInsertString(config, row, at, &ch, 1);
+}
+
 void editorRowAppendString(editorConfig *config, erow *row, char* s, size_t len){
-    row->chars = realloc(row->chars, row->size + len + 1);
-    memcpy(&row->chars[row->size], s, len);
-    row->size += len;
-    row->chars[row->size] = '\0';
+    ptInsert(&(*config).pt, editorRowOffset(config, row) + row->size, s, len);
+
+    if (row->gap){
+        gbInsert(row->gap, row->size, s, len);
+        row->size += len;
+        row->gap_dirty = true;
+    }else{
+        editorRowOwn(row);
+        char *chars = realloc(row->chars, row->size + len + 1);
+        if (chars == NULL){
+            die("row append");
+        }
+        row->chars = chars;
+        memcpy(&row->chars[row->size], s, len);
+        row->size += len;
+        row->chars[row->size] = '\0';
+    }
     editorUpdateRow(config, row);
     (*config).dirty++;
 }
@@ -165,8 +576,31 @@ void editorRowDelChar(editorConfig *config, erow *row, int at){
     if (at < 0 || at >= row->size){
         return;
     }
-    memmove(&row->chars[at], &row->chars[at + 1], row->size - at);
+    ptDelete(&(*config).pt, editorRowOffset(config, row) + at, 1);
+
+    editorRowOpenGap(config, row);
+    gbDelete(row->gap, at, 1);
     row->size--;
+    row->gap_dirty = true;
+
+    editorUpdateRow(config, row);
+    (*config).dirty++;
+}
+
+void editorRowTruncate(editorConfig *config, erow *row, int at){
+    if (at < 0 || at >= row->size){
+        return;
+    }
+    ptDelete(&(*config).pt, editorRowOffset(config, row) + at, row->size - at);
+
+    if (row->gap){
+        gbDelete(row->gap, at, row->size - at);
+        row->gap_dirty = true;
+    }
+    row->size = at;
+    if (row->owned && !row->gap){
+        row->chars[row->size] = '\0';
+    }
     editorUpdateRow(config, row);
     (*config).dirty++;
 }
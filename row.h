@@ -2,15 +2,35 @@
 #define KILO_ROW_H
 
 #include "text_highlighting.h"
+#include "gap_buffer.h"
 
+#define ROW_CACHE_MAX 1024
+
+// rows longer than this are only rendered and highlighted in a window around the viewport
+#define ROW_LONG_LINE 65536
+#define ROW_WINDOW_MARGIN 1024
+#define ROW_CHECKPOINT_CHARS 4096
+#define ROW_CHECKPOINT_SLACK 64
+
+erow *editorRowAt(editorConfig *config, int at);
 int editorRowCxToRx(editorConfig *config, erow *row, int cx);
+int editorRowWrapLines(editorConfig *config, erow *row);
 int editorRowRxToCx(editorConfig *config, erow *row, int rx);
+char *editorRowChars(erow *row);
+bool editorRowIsLong(erow *row);
+int editorRowCopyChars(erow *row, int from, int len, char *out);
+erow *editorRowRender(editorConfig *config, erow *row);
+erow *editorRowRenderRange(editorConfig *config, erow *row, int from, int len);
+erow *editorRenderedRowAt(editorConfig *config, int at);
 void editorUpdateRow(editorConfig *config, erow *row);
+void editorLoadRows(editorConfig *config, char *buf, size_t len, bool mapped);
 void editorInsertRow(editorConfig *config, int at, char *s, size_t len);
 void editorFreeRow(erow *row);
 void editorDelRow(editorConfig *config, int at);
+void editorRowInsertString(editorConfig *config, erow *row, int at, char *s, size_t len);
 void editorRowInsertChar(editorConfig *config, erow *row, int at, int c);
 void editorRowAppendString(editorConfig *config, erow *row, char* s, size_t len);
 void editorRowDelChar(editorConfig *config, erow *row, int at);
+void editorRowTruncate(editorConfig *config, erow *row, int at);
 
 #endif
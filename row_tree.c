@@ -0,0 +1,423 @@
+#include "row_tree.h"
+#include "utils.h"
+
+typedef struct rowSlab{
+    struct rowSlab *next;
+    int used;
+    erow rows[ROW_SLAB_ROWS];
+}rowSlab;
+
+static erow *rtAllocRow(rowTree *tree){
+    erow *row;
+    if (tree->free_count > 0){
+        row = tree->free_rows[--tree->free_count];
+    }else{
+        if (tree->slabs == NULL || tree->slabs->used == ROW_SLAB_ROWS){
+            rowSlab *slab = malloc(sizeof(rowSlab));
+            if (slab == NULL){
+                die("row slab");
+            }
+            slab->next = tree->slabs;
+            slab->used = 0;
+            tree->slabs = slab;
+        }
+        row = &tree->slabs->rows[tree->slabs->used++];
+    }
+
+    memset(row, 0, sizeof(erow));
+    return row;
+}
+
+static void rtReleaseRow(rowTree *tree, erow *row){
+    if (tree->free_count == tree->free_cap){
+        tree->free_cap = tree->free_cap ? tree->free_cap * 2 : 64;
+        tree->free_rows = realloc(tree->free_rows, sizeof(erow *) * tree->free_cap);
+        if (tree->free_rows == NULL){
+            die("row free list");
+        }
+    }
+    tree->free_rows[tree->free_count++] = row;
+}
+
+static rowNode *rtNewNode(bool leaf){
+    rowNode *node = malloc(sizeof(rowNode));
+    if (node == NULL){
+        die("row node");
+    }
+    node->leaf = leaf;
+    node->count = 0;
+    node->numrows = 0;
+    node->numlines = 0;
+    node->parent = NULL;
+    return node;
+}
+
+// numlines aggregates the rows' wrapped line counts the same way numrows counts rows
+static void rtAddNumrows(rowNode *node, int delta, int lines){
+    while (node){
+        node->numrows += delta;
+        node->numlines += lines;
+        node = node->parent;
+    }
+}
+
+static int rtChildIndex(rowNode *parent, rowNode *child){
+    int i = 0;
+    while (parent->children[i] != child){
+        i++;
+    }
+    return i;
+}
+
+static int rtRowIndex(rowNode *leaf, erow *row){
+    int i = 0;
+    while (leaf->rows[i] != row){
+        i++;
+    }
+    return i;
+}
+
+// moves n entries between two nodes, fixing back pointers and the nodes' own row counts
+static void rtMove(rowNode *from, int from_pos, int n, rowNode *to, int to_pos){
+    if (n == 0){
+        return;
+    }
+
+    int moved_rows = 0;
+    int moved_lines = 0;
+    if (from->leaf){
+        memmove(&to->rows[to_pos + n], &to->rows[to_pos], sizeof(erow *) * (to->count - to_pos));
+        memcpy(&to->rows[to_pos], &from->rows[from_pos], sizeof(erow *) * n);
+        memmove(&from->rows[from_pos], &from->rows[from_pos + n], sizeof(erow *) * (from->count - from_pos - n));
+        for (int i = to_pos; i < to_pos + n; i++){
+            to->rows[i]->block = to;
+            moved_lines += to->rows[i]->wrap_lines;
+        }
+        moved_rows = n;
+    }else{
+        memmove(&to->children[to_pos + n], &to->children[to_pos], sizeof(rowNode *) * (to->count - to_pos));
+        memcpy(&to->children[to_pos], &from->children[from_pos], sizeof(rowNode *) * n);
+        memmove(&from->children[from_pos], &from->children[from_pos + n], sizeof(rowNode *) * (from->count - from_pos - n));
+        for (int i = to_pos; i < to_pos + n; i++){
+            to->children[i]->parent = to;
+            moved_rows += to->children[i]->numrows;
+            moved_lines += to->children[i]->numlines;
+        }
+    }
+
+    from->count -= n;
+    to->count += n;
+    from->numrows -= moved_rows;
+    to->numrows += moved_rows;
+    from->numlines -= moved_lines;
+    to->numlines += moved_lines;
+}
+
+static rowNode *rtSplit(rowTree *tree, rowNode *node, int mid);
+
+static void rtInsertChild(rowTree *tree, rowNode *parent, int pos, rowNode *child){
+    if (parent->count == ROW_NODE_MAX){
+        int mid = pos == parent->count ? parent->count : parent->count / 2;
+        rowNode *sibling = rtSplit(tree, parent, mid);
+        if (pos > mid || parent->count == ROW_NODE_MAX){
+            parent = sibling;
+            pos -= mid;
+        }
+    }
+
+    memmove(&parent->children[pos + 1], &parent->children[pos], sizeof(rowNode *) * (parent->count - pos));
+    parent->children[pos] = child;
+    parent->count++;
+    child->parent = parent;
+    rtAddNumrows(parent, child->numrows, child->numlines);
+}
+
+// moves entries [mid, count) of node into a new right sibling and links it into the parent
+static rowNode *rtSplit(rowTree *tree, rowNode *node, int mid){
+    if (node->parent == NULL){
+        rowNode *root = rtNewNode(false);
+        root->children[0] = node;
+        root->count = 1;
+        root->numrows = node->numrows;
+        root->numlines = node->numlines;
+        node->parent = root;
+        tree->root = root;
+    }
+
+    rowNode *sibling = rtNewNode(node->leaf);
+    rtMove(node, mid, node->count - mid, sibling, 0);
+    rtAddNumrows(node->parent, -sibling->numrows, -sibling->numlines);
+    rtInsertChild(tree, node->parent, rtChildIndex(node->parent, node) + 1, sibling);
+
+    return sibling;
+}
+
+static void rtRebalance(rowTree *tree, rowNode *node){
+    rowNode *parent = node->parent;
+    if (parent == NULL){
+        if (node->count == 0){
+            free(node);
+            tree->root = NULL;
+        }else if (!node->leaf && node->count == 1){
+            tree->root = node->children[0];
+            tree->root->parent = NULL;
+            free(node);
+        }
+        return;
+    }
+
+    if (node->count == 0){
+        int pos = rtChildIndex(parent, node);
+        memmove(&parent->children[pos], &parent->children[pos + 1], sizeof(rowNode *) * (parent->count - pos - 1));
+        parent->count--;
+        free(node);
+        rtRebalance(tree, parent);
+        return;
+    }
+
+    if (node->count >= ROW_NODE_MIN || parent->count == 1){
+        return;
+    }
+
+    int i = rtChildIndex(parent, node);
+    rowNode *left = i > 0 ? parent->children[i - 1] : node;
+    rowNode *right = i > 0 ? node : parent->children[i + 1];
+
+    if (left->count + right->count <= ROW_NODE_MAX){
+        rtMove(right, 0, right->count, left, left->count);
+        int pos = rtChildIndex(parent, right);
+        memmove(&parent->children[pos], &parent->children[pos + 1], sizeof(rowNode *) * (parent->count - pos - 1));
+        parent->count--;
+        free(right);
+        rtRebalance(tree, parent);
+        return;
+    }
+
+    int target = (left->count + right->count) / 2;
+    if (left->count < target){
+        rtMove(right, 0, target - left->count, left, left->count);
+    }else{
+        rtMove(left, target, left->count - target, right, 0);
+    }
+}
+
+erow *rtGet(rowTree *tree, int at){
+    rowNode *node = tree->root;
+    if (node == NULL || at < 0 || at >= node->numrows){
+        return NULL;
+    }
+
+    while (!node->leaf){
+        int i = 0;
+        while (at >= node->children[i]->numrows){
+            at -= node->children[i]->numrows;
+            i++;
+        }
+        node = node->children[i];
+    }
+
+    return node->rows[at];
+}
+
+erow *rtInsert(rowTree *tree, int at){
+    if (tree->root == NULL){
+        tree->root = rtNewNode(true);
+    }
+
+    rowNode *node = tree->root;
+    while (!node->leaf){
+        int i;
+        if (at >= node->numrows){
+            i = node->count - 1;
+            at -= node->numrows - node->children[i]->numrows;
+        }else{
+            for (i = 0; i < node->count - 1; i++){
+                if (at <= node->children[i]->numrows){
+                    break;
+                }
+                at -= node->children[i]->numrows;
+            }
+        }
+        node = node->children[i];
+    }
+
+    if (node->count == ROW_NODE_MAX){
+        int mid = at == node->count ? node->count : node->count / 2;
+        rowNode *sibling = rtSplit(tree, node, mid);
+        if (at > mid || node->count == ROW_NODE_MAX){
+            node = sibling;
+            at -= mid;
+        }
+    }
+
+    erow *row = rtAllocRow(tree);
+    memmove(&node->rows[at + 1], &node->rows[at], sizeof(erow *) * (node->count - at));
+    node->rows[at] = row;
+    node->count++;
+    row->block = node;
+    row->wrap_lines = 1;
+    rtAddNumrows(node, 1, 1);
+
+    return row;
+}
+
+void rtDelete(rowTree *tree, int at){
+    erow *row = rtGet(tree, at);
+    if (row == NULL){
+        return;
+    }
+
+    rowNode *leaf = row->block;
+    int pos = rtRowIndex(leaf, row);
+    memmove(&leaf->rows[pos], &leaf->rows[pos + 1], sizeof(erow *) * (leaf->count - pos - 1));
+    leaf->count--;
+    rtAddNumrows(leaf, -1, -row->wrap_lines);
+    rtReleaseRow(tree, row);
+    rtRebalance(tree, leaf);
+}
+
+int rtIndex(erow *row){
+    rowNode *node = row->block;
+    int idx = rtRowIndex(node, row);
+
+    while (node->parent){
+        rowNode *parent = node->parent;
+        for (int i = 0; parent->children[i] != node; i++){
+            idx += parent->children[i]->numrows;
+        }
+        node = parent;
+    }
+
+    return idx;
+}
+
+erow *rtNext(erow *row){
+    rowNode *node = row->block;
+    int pos = rtRowIndex(node, row);
+    if (pos + 1 < node->count){
+        return node->rows[pos + 1];
+    }
+
+    while (node->parent){
+        rowNode *parent = node->parent;
+        int i = rtChildIndex(parent, node);
+        if (i + 1 < parent->count){
+            node = parent->children[i + 1];
+            while (!node->leaf){
+                node = node->children[0];
+            }
+            return node->rows[0];
+        }
+        node = parent;
+    }
+
+    return NULL;
+}
+
+erow *rtPrev(erow *row){
+    rowNode *node = row->block;
+    int pos = rtRowIndex(node, row);
+    if (pos > 0){
+        return node->rows[pos - 1];
+    }
+
+    while (node->parent){
+        rowNode *parent = node->parent;
+        int i = rtChildIndex(parent, node);
+        if (i > 0){
+            node = parent->children[i - 1];
+            while (!node->leaf){
+                node = node->children[node->count - 1];
+            }
+            return node->rows[node->count - 1];
+        }
+        node = parent;
+    }
+
+    return NULL;
+}
+
+int rtCount(rowTree *tree){
+    return tree->root ? tree->root->numrows : 0;
+}
+
+void rtSetLines(erow *row, int lines){
+    rtAddNumrows(row->block, 0, lines - row->wrap_lines);
+    row->wrap_lines = lines;
+}
+
+// screen line at which row starts when every row takes wrap_lines lines
+int rtLineIndex(erow *row){
+    rowNode *node = row->block;
+    int line = 0;
+    for (int i = 0; node->rows[i] != row; i++){
+        line += node->rows[i]->wrap_lines;
+    }
+
+    while (node->parent){
+        rowNode *parent = node->parent;
+        for (int i = 0; parent->children[i] != node; i++){
+            line += parent->children[i]->numlines;
+        }
+        node = parent;
+    }
+
+    return line;
+}
+
+// row covering screen line `line`, with the line's offset inside that row
+erow *rtLineAt(rowTree *tree, int line, int *offset){
+    rowNode *node = tree->root;
+    if (node == NULL || line < 0 || line >= node->numlines){
+        return NULL;
+    }
+
+    while (!node->leaf){
+        int i = 0;
+        while (line >= node->children[i]->numlines){
+            line -= node->children[i]->numlines;
+            i++;
+        }
+        node = node->children[i];
+    }
+
+    int i = 0;
+    while (line >= node->rows[i]->wrap_lines){
+        line -= node->rows[i]->wrap_lines;
+        i++;
+    }
+    *offset = line;
+    return node->rows[i];
+}
+
+int rtCountLines(rowTree *tree){
+    return tree->root ? tree->root->numlines : 0;
+}
+
+static void rtFreeNode(rowNode *node){
+    if (node == NULL){
+        return;
+    }
+    if (!node->leaf){
+        for (int i = 0; i < node->count; i++){
+            rtFreeNode(node->children[i]);
+        }
+    }
+    free(node);
+}
+
+void rtFree(rowTree *tree){
+    rtFreeNode(tree->root);
+    tree->root = NULL;
+
+    while (tree->slabs){
+        rowSlab *next = tree->slabs->next;
+        free(tree->slabs);
+        tree->slabs = next;
+    }
+
+    free(tree->free_rows);
+    tree->free_rows = NULL;
+    tree->free_count = 0;
+    tree->free_cap = 0;
+}
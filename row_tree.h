@@ -0,0 +1,45 @@
+#ifndef KILO_ROW_TREE_H
+#define KILO_ROW_TREE_H
+
+#include <stdbool.h>
+
+#define ROW_NODE_MAX 64
+#define ROW_NODE_MIN (ROW_NODE_MAX / 4)
+#define ROW_SLAB_ROWS 1024
+
+struct erow;
+
+typedef struct rowNode{
+    bool leaf;
+    int count;
+    int numrows;
+    int numlines;
+    struct rowNode *parent;
+    union{
+        struct rowNode *children[ROW_NODE_MAX];
+        struct erow *rows[ROW_NODE_MAX];
+    };
+}rowNode;
+
+typedef struct rowTree{
+    rowNode *root;
+    struct rowSlab *slabs;
+    struct erow **free_rows;
+    int free_count;
+    int free_cap;
+}rowTree;
+
+struct erow *rtGet(rowTree *tree, int at);
+struct erow *rtInsert(rowTree *tree, int at);
+void rtDelete(rowTree *tree, int at);
+int rtIndex(struct erow *row);
+struct erow *rtNext(struct erow *row);
+struct erow *rtPrev(struct erow *row);
+int rtCount(rowTree *tree);
+void rtSetLines(struct erow *row, int lines);
+int rtLineIndex(struct erow *row);
+struct erow *rtLineAt(rowTree *tree, int line, int *offset);
+int rtCountLines(rowTree *tree);
+void rtFree(rowTree *tree);
+
+#endif
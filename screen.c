@@ -1,11 +1,54 @@
 #include "screen.h"
 #include "append_buffer.h"
 #include "utils.h"
+#include <limits.h>
+
+// with soft wrap rowoff/wrapoff name the first screen line and scrolling is done in
+// wrapped lines, located through the row tree's line counts
+static void editorScrollWrapped(editorConfig *config){
+    int cols = (*config).screencols > 0 ? (*config).screencols : 1;
+    int total = rtCountLines(&(*config).rows);
+    (*config).coloff = 0;
+
+    int cursor_line = total;
+    int cursor_col = 0;
+    erow *row = editorRowAt(config, (*config).cy);
+    if (row){
+        int col = (*config).rx - (*config).last_row_digits;
+        int seg = min(col / cols, editorRowWrapLines(config, row) - 1);
+        cursor_line = rtLineIndex(row) + seg;
+        cursor_col = min(col - seg * cols, cols - 1);
+    }
+
+    int top_line = total;
+    erow *top = editorRowAt(config, (*config).rowoff);
+    if (top){
+        top_line = rtLineIndex(top) + min((*config).wrapoff, editorRowWrapLines(config, top) - 1);
+    }
+    if (cursor_line < top_line){
+        top_line = cursor_line;
+    }
+    if (cursor_line >= top_line + (*config).screenrows){
+        top_line = cursor_line - (*config).screenrows + 1;
+    }
+
+    int offset = 0;
+    top = rtLineAt(&(*config).rows, top_line, &offset);
+    (*config).rowoff = top ? rtIndex(top) : (*config).numrows;
+    (*config).wrapoff = top ? offset : 0;
+    (*config).lineoff = top_line;
+    (*config).cursor_sy = cursor_line - top_line;
+    (*config).cursor_sx = cursor_col + (*config).last_row_digits;
+}
 
 void editorScroll(editorConfig *config) {
     (*config).rx = config->last_row_digits;
     if ((*config).cy < (*config).numrows){
-        (*config).rx = editorRowCxToRx(config, &(*config).row[(*config).cy], editor_cx_to_index(config));
+        (*config).rx = editorRowCxToRx(config, editorRowAt(config, (*config).cy), editor_cx_to_index(config));
+    }
+    if ((*config).soft_wrap){
+        editorScrollWrapped(config);
+        return;
     }
     if ((*config).cy < (*config).rowoff) {
         (*config).rowoff = (*config).cy;
@@ -19,12 +62,136 @@ void editorScroll(editorConfig *config) {
     if ((*config).rx - config->last_row_digits >= (*config).coloff + (*config).screencols) {
         (*config).coloff = (*config).rx - config->last_row_digits - (*config).screencols + 1;
     }
+    (*config).lineoff = (*config).rowoff;
+    (*config).cursor_sy = (*config).cy - (*config).rowoff;
+    (*config).cursor_sx = (*config).rx - (*config).coloff;
+}
+
+// moves the cursor a screen up or down, in wrapped lines with soft wrap, and leaves
+// it to editorScroll to bring the view along
+void editorScrollPage(editorConfig *config, int dir){
+    if ((*config).numrows == 0){
+        return;
+    }
+    int col = max((*config).last_cx - (*config).last_row_digits, 0);
+    int page = dir < 0 ? -(*config).screenrows : 2 * (*config).screenrows - 1;
+    if (!(*config).soft_wrap){
+        (*config).cy = max(min((*config).rowoff + page, (*config).numrows - 1), 0);
+        erow *row = editorRowAt(config, (*config).cy);
+        (*config).cx = min(col, row->size) + (*config).last_row_digits;
+        return;
+    }
+
+    int cols = (*config).screencols > 0 ? (*config).screencols : 1;
+    int line = max(min((*config).lineoff + page, rtCountLines(&(*config).rows) - 1), 0);
+    int seg = 0;
+    erow *row = rtLineAt(&(*config).rows, line, &seg);
+    (*config).cy = rtIndex(row);
+    (*config).cx = editorRowRxToCx(config, row, seg * cols + col % cols);
+}
+
+static screenCell *editorScreenLine(editorConfig *config, int y){
+    return &(*config).screen_next[y * (*config).screen_cols];
 }
 
-void editorDrawRows(editorConfig *config, struct abuf *ab){
+static int editorPutText(editorConfig *config, int y, int x, const char *s, int len, unsigned char attr){
+    screenCell *line = editorScreenLine(config, y);
+    for (int i = 0; i < len && x < (*config).screen_cols; i++, x++){
+        line[x].ch = s[i];
+        line[x].attr = attr;
+    }
+    return x;
+}
+
+// makes sure both grids match the terminal size; a new size forces a full repaint
+static void editorResizeScreen(editorConfig *config){
+    int rows = (*config).screenrows + 2;
+    int cols = (*config).screencolsBase;
+    if ((*config).screen_next && rows == (*config).screen_rows && cols == (*config).screen_cols){
+        return;
+    }
+
+    free((*config).screen_prev);
+    free((*config).screen_next);
+    (*config).screen_prev = malloc(sizeof(screenCell) * rows * cols);
+    (*config).screen_next = malloc(sizeof(screenCell) * rows * cols);
+    if ((*config).screen_prev == NULL || (*config).screen_next == NULL){
+        die("screen");
+    }
+    (*config).screen_rows = rows;
+    (*config).screen_cols = cols;
+    (*config).full_redraw = true;
+}
+
+// SGR fragments per attribute component, built once from the theme colors
+typedef struct screenTheme{
+    bool built;
+    unsigned char hl_attr[256];
+    char fg[ATTR_FG_MASK + 1][3];
+    char selected[16];
+    int selected_len;
+}screenTheme;
+
+static screenTheme theme;
+
+static void editorBuildTheme(){
+    for (int hl = 0; hl < 256; hl++){
+        theme.hl_attr[hl] = hl == HL_NORMAL ? ATTR_DEFAULT : ATTR_FG(editorSyntaxToColor(hl));
+    }
+    for (int fg = 0; fg <= ATTR_FG_MASK; fg++){
+        theme.fg[fg][0] = '3';
+        theme.fg[fg][1] = '0' + fg % 10;
+    }
+    int palette = -1;
+    int index_in_palette = -1;
+    int h_color = editorHighlightToColor(VHL_HIGHLIGHT, &palette, &index_in_palette);
+    theme.selected_len = snprintf(theme.selected, sizeof(theme.selected), "%d;%d;%d", h_color, palette, index_in_palette);
+    theme.built = true;
+}
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// writes the right-aligned line number and its trailing space straight into the grid
+static int editorDrawGutter(editorConfig *config, int y, int line, unsigned char attr){
+    int width = (*config).last_row_digits;
+    if (width > (*config).screen_cols){
+        width = (*config).screen_cols;
+    }
+    screenCell *cells = editorScreenLine(config, y);
+    for (int x = 0; x < width; x++){
+        cells[x].ch = ' ';
+        cells[x].attr = attr;
+    }
+
+    int x = width - 1;
+    while (line >= 10 && x >= 2){
+        int pair = (line % 100) * 2;
+        cells[--x].ch = digit_pairs[pair + 1];
+        cells[--x].ch = digit_pairs[pair];
+        line /= 100;
+    }
+    // a single digit is left, unless the gutter was cut down to the screen width
+    if (line > 0 && x >= 1){
+        cells[--x].ch = '0' + line % 10;
+    }
+    return width;
+}
+
+void editorDrawRows(editorConfig *config){
     int y;
+    int filerow = (*config).rowoff;
+    int seg = (*config).soft_wrap ? (*config).wrapoff : 0;
     for (y = 0; y < (*config).screenrows; y++){
-        int filerow = y + (*config).rowoff;
         if (filerow >= (*config).numrows){
             if ((*config).numrows == 0 && y == (*config).screenrows / 3){
                 char welcome[80];
@@ -34,151 +201,81 @@ void editorDrawRows(editorConfig *config, struct abuf *ab){
                     welcomelen = (*config).screencols;
                 }
                 int padding = ((*config).screencols - welcomelen) / 2;
+                int x = 0;
                 if (padding){
-                    abAppend(ab, "~", 1);
+                    x = editorPutText(config, y, x, "~", 1, ATTR_DEFAULT);
                     padding--;
                 }
-                while (padding--) {
-                    abAppend(ab, " ", 1);
-                }
-                abAppend(ab, welcome, welcomelen);
+                x += padding;
+                editorPutText(config, y, x, welcome, welcomelen, ATTR_DEFAULT);
             }else{
-                abAppend(ab, "~", 1);
+                editorPutText(config, y, 0, "~", 1, ATTR_DEFAULT);
             }
         }else{
-            if ((*config).relative_line_numbers){
-                int line = (*config).row[filerow].idx == (*config).cy ? (*config).row[filerow].idx + 1 : abs((*config).cy - (*config).row[filerow].idx);
-                int line_num_digits = count_digits(line);
-                int padding = (*config).last_row_digits - line_num_digits - 1;
-
-                char *line_num = malloc(sizeof(char) * ((*config).last_row_digits + 2));
-                if (line_num == NULL) {
-                    die("draw rows");
-                }
-
-                memset(line_num, ' ', padding);
-
-                snprintf(line_num + padding, line_num_digits + 1, "%d", line);
-
-                line_num[padding + line_num_digits] = ' ';
-
-                line_num[padding + line_num_digits + 1] = '\0';
-    
-                if ((*config).row[filerow].idx == (*config).cy){
-                    abAppend(ab, "\x1b[33m", 5);
-                    abAppend(ab, line_num, (*config).last_row_digits + 1);
-                    abAppend(ab, "\x1b[0m", 4);
-                }else{
-                    abAppend(ab, line_num, (*config).last_row_digits + 1);
-                }
+            erow *row = editorRowAt(config, filerow);
+            int coloff = (*config).coloff;
+            if ((*config).soft_wrap){
+                editorRowWrapLines(config, row);
+                coloff = seg * (*config).screencols;
+            }
+            editorRowRenderRange(config, row, coloff, (*config).screencols);
 
-                free(line_num);
+            int x = 0;
+            if ((*config).line_numbers && seg > 0){
+                x = min((*config).last_row_digits, (*config).screen_cols);
             }else if ((*config).line_numbers){
-                int line_num_digits = count_digits((*config).row[filerow].idx + 1);
-                int padding = (*config).last_row_digits - line_num_digits - 1;
-
-                char *line_num = malloc(sizeof(char) * ((*config).last_row_digits + 2));
-                if (line_num == NULL) {
-                    die("draw rows");
-                }
-
-                memset(line_num, ' ', padding);
-
-                snprintf(line_num + padding, line_num_digits + 1, "%d", (*config).row[filerow].idx + 1);
-
-                line_num[padding + line_num_digits] = ' ';
-
-                line_num[padding + line_num_digits + 1] = '\0';
-
-                if ((*config).row[filerow].idx == (*config).cy){
-                    abAppend(ab, "\x1b[33m", 5);
-                    abAppend(ab, line_num, (*config).last_row_digits + 1);
-                    abAppend(ab, "\x1b[0m", 4);
-                }else{
-                    abAppend(ab, line_num, (*config).last_row_digits + 1);
+                int line = filerow + 1;
+                if ((*config).relative_line_numbers && filerow != (*config).cy){
+                    line = abs((*config).cy - filerow);
                 }
-
-                free(line_num);
+                x = editorDrawGutter(config, y, line, filerow == (*config).cy ? ATTR_FG(33) : ATTR_DEFAULT);
             }
 
-            int len = (*config).row[filerow].rsize - (*config).coloff;
+            int len = row->rsize - coloff;
             if (len < 0) {
                 len = 0;
+                coloff = row->rsize;
             }
             if (len > (*config).screencols){
                 len = (*config).screencols;
             }
-            char *c = &(*config).row[filerow].render[(*config).coloff];
-            unsigned char *hl = &(*config).row[filerow].hl[(*config).coloff];
-            unsigned char *vhl = &(*config).row[filerow].vhl[(*config).coloff];
-            if (vhl == NULL){
-                die("vhl null");
+            // long rows only hold a window of their render
+            len = min(len, row->render_off + row->render_len - coloff);
+            char *c = &row->render[coloff - row->render_off];
+            unsigned char *hl = &row->hl[coloff - row->render_off];
+            int sel_start = 0, sel_end = 0;
+            if (editorSelectionInRow(config, filerow, &sel_start, &sel_end)){
+                sel_start -= coloff;
+                sel_end = sel_end == INT_MAX ? len : sel_end - coloff;
             }
-            for (int g = 0; g < (*config).row[filerow].rsize; g++){
-            }
-            int current_color = -1;
-            int current_highlite = -1;
+
+            screenCell *line = editorScreenLine(config, y);
             int j;
-            for (j = 0; j < len; j++) {
-                if (vhl[j] == VHL_NORMAL){
-                    if (current_highlite!= -1){
-                        current_highlite= -1;
-                        abAppend(ab, "\x1b[49m", 5);
-                    }
-                }else{
-                    int palette = -1;
-                    int index_in_palette = -1;
-                    int h_color = editorHighlightToColor(vhl[j], &palette, &index_in_palette);
-                    if (current_highlite != h_color){
-                        current_highlite = h_color;
-                        char buf[64];
-                        if (palette != -1 || index_in_palette != -1){
-                            int clen = snprintf(buf, sizeof(buf), "\x1b[%d;%d;%dm", h_color, palette, index_in_palette);
-                            abAppend(ab, buf, clen);
-                        }else{
-                            int clen = snprintf(buf, sizeof(buf), "\x1b[%dm", h_color);
-                            abAppend(ab, buf, clen);
-                        }
-                    }
+            for (j = 0; j < len && x < (*config).screen_cols; j++, x++) {
+                unsigned char attr = theme.hl_attr[hl[j]];
+                if (j >= sel_start && j < sel_end){
+                    attr |= ATTR_SELECTED;
                 }
                 if (iscntrl(c[j])) {
-                    char sym = (c[j] <= 26) ? '@' + c[j] : '?';
-                    abAppend(ab, "\x1b[7m", 4);
-                    abAppend(ab, &sym, 1);
-                    abAppend(ab, "\x1b[m", 3);
-                    if (current_color != -1) {
-                        char buf[16];
-                        int clen = snprintf(buf, sizeof(buf), "\x1b[%dm", current_color);
-                        abAppend(ab, buf, clen);
-                    }
-                } else if (hl[j] == HL_NORMAL) {
-                    if (current_color != -1){
-                        current_color = -1;
-                        abAppend(ab, "\x1b[39m", 5);
-                    }
-                    abAppend(ab, &c[j], 1);
+                    line[x].ch = (c[j] <= 26) ? '@' + c[j] : '?';
+                    line[x].attr = attr | ATTR_REVERSE;
                 } else {
-                    int color = editorSyntaxToColor(hl[j]);
-                    if (current_color != color){
-                        current_color = color;
-                        char buf[16];
-                        int clen = snprintf(buf, sizeof(buf), "\x1b[%dm", color);
-                        abAppend(ab, buf, clen);
-                    }
-                    abAppend(ab, &c[j], 1);
+                    line[x].ch = c[j];
+                    line[x].attr = attr;
                 }
             }
-            abAppend(ab, "\x1b[39m", 5);
-            abAppend(ab, "\x1b[49m", 5);
-        }
 
-        abAppend(ab, "\x1b[K", 3);
-        abAppend(ab, "\r\n", 2);
+            if ((*config).soft_wrap && ++seg < row->wrap_lines){
+                continue;
+            }
+            seg = 0;
+        }
+        filerow++;
     }
 }
 
-void editorDrawStatusBar(editorConfig *config, struct abuf *ab){
-    abAppend(ab, "\x1b[7m", 4);
+void editorDrawStatusBar(editorConfig *config){
+    int y = (*config).screenrows;
     char status[87], rstatus[80];
     char mode[7];
     switch ((*config).mode) {
@@ -200,53 +297,271 @@ void editorDrawStatusBar(editorConfig *config, struct abuf *ab){
     }
     int len = snprintf(status, sizeof(status), "%.20s - %d lines %s %s", (*config).filename ? (*config).filename : "[No Name]", (*config).numrows, (*config).dirty ? "(modified)" : "",
                        mode);
-    int rlen = snprintf(rstatus, sizeof(rstatus), "%s | %d/%d:%d", (*config).syntax ? (*config).syntax->filetype : "no ft", (*config).cy + 1, (*config).numrows, editor_cx_to_index(config) + 1);
+    int rlen;
+    if ((*config).perf.enabled){
+        perfStats *perf = &(*config).perf;
+        rlen = snprintf(rstatus, sizeof(rstatus), "%.0fus p50 %.0f p99 %.0f | %zuB %dr | syn %.0fus",
+                        perf->frame_us, perfPercentile(perf, 0.50), perfPercentile(perf, 0.99),
+                        perf->bytes, perf->rows_redrawn, perf->syntax_us);
+    }else{
+        rlen = snprintf(rstatus, sizeof(rstatus), "%s | %d/%d:%d", (*config).syntax ? (*config).syntax->filetype : "no ft", (*config).cy + 1, (*config).numrows, editor_cx_to_index(config) + 1);
+    }
     if (len > (*config).screencols) {
         len = (*config).screencols;
     }
-    abAppend(ab, status, len);
+    int x = editorPutText(config, y, 0, status, len, ATTR_DEFAULT | ATTR_REVERSE);
 
     while(len++ < (*config).screencols){
         if ((*config).screencols - len == rlen) {
-            abAppend(ab, rstatus, rlen);
+            editorPutText(config, y, x, rstatus, rlen, ATTR_DEFAULT | ATTR_REVERSE);
             break;
         }else{
-            abAppend(ab, " ", 1);
+            x = editorPutText(config, y, x, " ", 1, ATTR_DEFAULT | ATTR_REVERSE);
         }
     }
-
-    abAppend(ab, "\x1b[m", 3);
-    abAppend(ab, "\r\n", 2);
 }
 
-void editorDrawMessageBar(editorConfig *config, struct abuf *ab) {
-    abAppend(ab, "\x1b[K", 3);
+void editorDrawMessageBar(editorConfig *config) {
     int msglen = strlen((*config).statusmsg);
     if (msglen > (*config).screencols) msglen = (*config).screencols;
     if (msglen && time(NULL) - (*config).statusmsg_time < 5)
-        abAppend(ab, (*config).statusmsg, msglen);
+        editorPutText(config, (*config).screenrows + 1, 0, (*config).statusmsg, msglen, ATTR_DEFAULT);
+}
+
+static void editorAppendParam(char *buf, int *len, const char *s, int slen){
+    if (*len > 2){
+        buf[(*len)++] = ';';
+    }
+    memcpy(buf + *len, s, slen);
+    *len += slen;
+}
+
+// emits only the SGR parameters that differ between the current and the wanted attribute
+static void editorAppendAttr(struct abuf *ab, unsigned char from, unsigned char to){
+    if (to == ATTR_DEFAULT){
+        abAppend(ab, "\x1b[m", 3);
+        return;
+    }
+
+    char buf[32] = "\x1b[";
+    int len = 2;
+    if ((from ^ to) & ATTR_REVERSE){
+        editorAppendParam(buf, &len, to & ATTR_REVERSE ? "7" : "27", to & ATTR_REVERSE ? 1 : 2);
+    }
+    if ((from ^ to) & ATTR_FG_MASK){
+        editorAppendParam(buf, &len, theme.fg[to & ATTR_FG_MASK], 2);
+    }
+    if ((from ^ to) & ATTR_SELECTED){
+        if (to & ATTR_SELECTED){
+            editorAppendParam(buf, &len, theme.selected, theme.selected_len);
+        }else{
+            editorAppendParam(buf, &len, "49", 2);
+        }
+    }
+    buf[len++] = 'm';
+    abAppend(ab, buf, len);
+}
+
+static void editorAppendNumber(struct abuf *ab, int n){
+    char digits[12];
+    int i = sizeof(digits);
+    do {
+        digits[--i] = '0' + n % 10;
+        n /= 10;
+    } while (n);
+    abAppend(ab, digits + i, sizeof(digits) - i);
+}
+
+static void editorAppendCursor(struct abuf *ab, int y, int x){
+    abAppend(ab, "\x1b[", 2);
+    editorAppendNumber(ab, y);
+    abAppend(ab, ";", 1);
+    editorAppendNumber(ab, x);
+    abAppend(ab, "H", 1);
+}
+
+static bool editorLineIsWide(screenCell *line, int cols){
+    for (int x = 0; x < cols; x++){
+        if ((unsigned char)line[x].ch >= 0x80){
+            return true;
+        }
+    }
+    return false;
+}
+
+// emits cells [from, to) of screen row y; anything past the last visible cell is erased instead
+static void editorEmitRun(editorConfig *config, struct abuf *ab, int y, int from, int to, int last, int *attr){
+    editorAppendCursor(ab, y + 1, from + 1);
+
+    screenCell *line = editorScreenLine(config, y);
+    int end = to < last + 1 ? to : last + 1;
+    int x = from;
+    while (x < end){
+        if (line[x].attr != *attr){
+            editorAppendAttr(ab, *attr, line[x].attr);
+            *attr = line[x].attr;
+        }
+        int run = x;
+        while (run < end && line[run].attr == *attr){
+            run++;
+        }
+        char *out = abReserve(ab, run - x);
+        for (; x < run; x++){
+            *out++ = line[x].ch;
+        }
+    }
+    if (to > last + 1){
+        if (*attr != ATTR_DEFAULT){
+            *attr = ATTR_DEFAULT;
+            abAppend(ab, "\x1b[m", 3);
+        }
+        abAppend(ab, "\x1b[K", 3);
+    }
+}
+
+// shifts the text area with a scroll region when rowoff moved by less than a screen,
+// so the diff below only has to fill in the exposed lines
+static void editorScrollScreen(editorConfig *config, struct abuf *ab){
+    int delta = (*config).lineoff - (*config).screen_lineoff;
+    int rows = (*config).screenrows;
+    if ((*config).full_redraw || delta == 0 || abs(delta) >= rows){
+        return;
+    }
+
+    int cols = (*config).screen_cols;
+    int shift = abs(delta);
+    abAppend(ab, "\x1b[1;", 4);
+    editorAppendNumber(ab, rows);
+    abAppend(ab, "r\x1b[", 3);
+    editorAppendNumber(ab, shift);
+    abAppend(ab, delta > 0 ? "S" : "T", 1);
+    abAppend(ab, "\x1b[r", 3);
+
+    screenCell *prev = (*config).screen_prev;
+    screenCell *exposed;
+    if (delta > 0){
+        memmove(prev, prev + shift * cols, sizeof(screenCell) * (rows - shift) * cols);
+        exposed = prev + (rows - shift) * cols;
+    }else{
+        memmove(prev + shift * cols, prev, sizeof(screenCell) * (rows - shift) * cols);
+        exposed = prev;
+    }
+    for (int i = 0; i < shift * cols; i++){
+        exposed[i].ch = ' ';
+        exposed[i].attr = ATTR_DEFAULT;
+    }
+}
+
+// diffs the new grid against what the terminal already shows and emits only the changed runs;
+// returns how many rows had to be touched
+static int editorFlushScreen(editorConfig *config, struct abuf *ab){
+    int cols = (*config).screen_cols;
+    int attr = ATTR_DEFAULT;
+    int redrawn = 0;
+    abAppend(ab, "\x1b[m", 3);
+    editorScrollScreen(config, ab);
+
+    for (int y = 0; y < (*config).screen_rows; y++){
+        screenCell *next = editorScreenLine(config, y);
+        screenCell *prev = &(*config).screen_prev[y * cols];
+
+        int last = cols - 1;
+        while (last >= 0 && next[last].ch == ' ' && next[last].attr == ATTR_DEFAULT){
+            last--;
+        }
+
+        // byte columns only match terminal columns for plain ASCII, so such lines are rewritten whole
+        if ((*config).full_redraw || editorLineIsWide(next, cols) || editorLineIsWide(prev, cols)){
+            if ((*config).full_redraw || memcmp(next, prev, sizeof(screenCell) * cols)){
+                editorEmitRun(config, ab, y, 0, cols, last, &attr);
+                redrawn++;
+            }
+            continue;
+        }
+
+        int x = 0;
+        int runs = 0;
+        while (x < cols){
+            if (next[x].ch == prev[x].ch && next[x].attr == prev[x].attr){
+                x++;
+                continue;
+            }
+
+            int from = x;
+            int to = x + 1;
+            for (x = to; x < cols && x - to < SCREEN_RUN_GAP; x++){
+                if (next[x].ch != prev[x].ch || next[x].attr != prev[x].attr){
+                    to = x + 1;
+                }
+            }
+            if (to > last + 1){
+                to = cols;
+            }
+            editorEmitRun(config, ab, y, from, to, last, &attr);
+            runs++;
+            x = to;
+        }
+        if (runs){
+            redrawn++;
+        }
+    }
+
+    if (attr != ATTR_DEFAULT){
+        abAppend(ab, "\x1b[m", 3);
+    }
+
+    return redrawn;
 }
 
 void editorRefreshScreen(editorConfig *config){
+    double start = (*config).perf.enabled ? perfNow() : 0;
+    if (!theme.built){
+        editorBuildTheme();
+    }
     editorScroll(config);
+    editorResizeScreen(config);
+
+    for (int i = 0; i < (*config).screen_rows * (*config).screen_cols; i++){
+        (*config).screen_next[i].ch = ' ';
+        (*config).screen_next[i].attr = ATTR_DEFAULT;
+    }
+    editorDrawRows(config);
+    editorDrawStatusBar(config);
+    editorDrawMessageBar(config);
+
+    // the frame buffer lives across refreshes so steady-state frames reuse its capacity
+    struct abuf *ab = &(*config).frame;
+    abReset(ab);
 
-    struct abuf ab = ABUF_INIT;
+    abAppend(ab, "\x1b[?25l", 6);
+    int redrawn = editorFlushScreen(config, ab);
 
-    abAppend(&ab, "\x1b[?25l", 6);
-    abAppend(&ab, "\x1b[H", 3);
+    editorAppendCursor(ab, (*config).cursor_sy + 1, (*config).cursor_sx + 1);
 
-    editorDrawRows(config, &ab);
-    editorDrawStatusBar(config, &ab);
-    editorDrawMessageBar(config, &ab);
-    
-    char buf[32];
-    snprintf(buf, sizeof(buf), "\x1b[%d;%dH", ((*config).cy - (*config).rowoff) + 1, ((*config).rx - (*config).coloff) + 1);
-    abAppend(&ab, buf, strlen(buf));
+    abAppend(ab, "\x1b[?25h", 6);
 
-    abAppend(&ab, "\x1b[?25h", 6);
+    if ((*config).perf.enabled){
+        perfRecordFrame(&(*config).perf, perfNow() - start, ab->len, redrawn);
+    }
+
+    // with synchronized output the terminal holds the frame until it is complete
+    struct iovec iov[3];
+    int iovcnt = 0;
+    if ((*config).sync_output){
+        iov[iovcnt++] = (struct iovec){"\x1b[?2026h", 8};
+    }
+    iov[iovcnt++] = (struct iovec){ab->b, ab->len};
+    if ((*config).sync_output){
+        iov[iovcnt++] = (struct iovec){"\x1b[?2026l", 8};
+    }
+    writeAll(STDOUT_FILENO, iov, iovcnt);
+    (*config).frame_bytes = ab->len;
 
-    write(STDOUT_FILENO, ab.b, ab.len);
-    abFree(&ab);
+    screenCell *shown = (*config).screen_prev;
+    (*config).screen_prev = (*config).screen_next;
+    (*config).screen_next = shown;
+    (*config).screen_lineoff = (*config).lineoff;
+    (*config).full_redraw = false;
 }
 
 void editorSetStatusMessage(editorConfig *config, const char *fmt, ...) {
@@ -6,13 +6,30 @@
 #include "append_buffer.h"
 #include "row.h"
 
+// a cell's attr packs the foreground as an SGR color minus 30 (ATTR_DEFAULT is 39) plus flag bits
+#define ATTR_FG_MASK 0x0f
+#define ATTR_FG(color) ((color) - 30)
+#define ATTR_DEFAULT ATTR_FG(39)
+#define ATTR_SELECTED 0x10
+#define ATTR_REVERSE 0x20
+
+// unchanged cells shorter than this between two changes are resent rather than skipped with a cursor move
+#define SCREEN_RUN_GAP 6
+
+typedef struct screenCell{
+    char ch;
+    unsigned char attr;
+}screenCell;
+
 void editorScroll(editorConfig *config);
 
-void editorDrawRows(editorConfig *config, struct abuf *ab);
+void editorScrollPage(editorConfig *config, int dir);
+
+void editorDrawRows(editorConfig *config);
 
-void editorDrawStatusBar(editorConfig *config, struct abuf *ab);
+void editorDrawStatusBar(editorConfig *config);
 
-void editorDrawMessageBar(editorConfig *config, struct abuf *ab);
+void editorDrawMessageBar(editorConfig *config);
 
 void editorRefreshScreen(editorConfig *config);
 
@@ -0,0 +1,138 @@
+#include "syntax_config.h"
+#include "utils.h"
+#include "text_highlighting.h"
+
+// every name looked up so far, misses included, so a file is read at most once
+typedef struct syntaxEntry{
+    char *name;
+    editorSyntax *syntax;
+    struct syntaxEntry *next;
+}syntaxEntry;
+
+static syntaxEntry *syntax_entries = NULL;
+
+static char *syntax_value(HashTable *section, char *key){
+    Ht_item *item = ht_search(section, key);
+    if (item == NULL || item->value_type != TYPE_STR || ((char *)item->value)[0] == '\0'){
+        return NULL;
+    }
+    return strdup((char *)item->value);
+}
+
+// appends the whitespace separated words of value to words, with suffix added to each
+static int syntax_words(char ***words, int count, char *value, const char *suffix){
+    if (value == NULL){
+        return count;
+    }
+
+    char *save;
+    for (char *word = strtok_r(value, " \t", &save); word; word = strtok_r(NULL, " \t", &save)){
+        char *copy = malloc(strlen(word) + strlen(suffix) + 1);
+        *words = realloc(*words, sizeof(char *) * (count + 2));
+        if (copy == NULL || *words == NULL){
+            die("syntax keywords");
+        }
+        sprintf(copy, "%s%s", word, suffix);
+        (*words)[count++] = copy;
+        (*words)[count] = NULL;
+    }
+    free(value);
+    return count;
+}
+
+static editorSyntax *syntax_from_ini(Ini *ini, const char *name){
+    Ht_item *section_item = ht_search(ini->sections, "syntax");
+    if (section_item == NULL || section_item->value_type != TYPE_HASH_TABLE){
+        return NULL;
+    }
+    HashTable *section = (HashTable *)section_item->value;
+
+    editorSyntax *s = calloc(1, sizeof(editorSyntax));
+    char **filematch = calloc(2, sizeof(char *));
+    char *ext = malloc(strlen(name) + 2);
+    if (s == NULL || filematch == NULL || ext == NULL){
+        die("syntax");
+    }
+    sprintf(ext, ".%s", name);
+    filematch[0] = ext;
+    s->filematch = filematch;
+
+    s->filetype = syntax_value(section, "name");
+    if (s->filetype == NULL){
+        s->filetype = strdup(name);
+    }
+
+    int count = syntax_words(&s->keywords, 0, syntax_value(section, "keywords"), "");
+    syntax_words(&s->keywords, count, syntax_value(section, "types"), "|");
+
+    s->singleline_comment_start = syntax_value(section, "singleline_comment");
+    s->multiline_comment_start = syntax_value(section, "multiline_comment_start");
+    s->multiline_comment_end = syntax_value(section, "multiline_comment_end");
+    s->separators = syntax_value(section, "separators");
+
+    // string delimiters are listed as separate (usually quoted) characters
+    char *strings = syntax_value(section, "strings");
+    if (strings){
+        int len = 0;
+        for (char *c = strings; *c; c++){
+            if (!isspace((unsigned char)*c)){
+                strings[len++] = *c;
+            }
+        }
+        strings[len] = '\0';
+        s->strings = strings;
+        s->flags |= HL_HIGHLIGHT_STRINGS;
+    }
+
+    char *numbers = syntax_value(section, "numbers");
+    if (numbers && strcmp(numbers, "true") == 0){
+        s->flags |= HL_HIGHLIGHT_NUMBERS;
+    }
+    free(numbers);
+
+    return s;
+}
+
+// loads SYNTAX_DIR/<name>.ini the first time name is asked for; definitions that are never
+// asked for are never read
+editorSyntax *editorLoadSyntax(const char *name){
+    for (syntaxEntry *entry = syntax_entries; entry; entry = entry->next){
+        if (strcmp(entry->name, name) == 0){
+            return entry->syntax;
+        }
+    }
+
+    syntaxEntry *entry = malloc(sizeof(syntaxEntry));
+    if (entry == NULL || (entry->name = strdup(name)) == NULL){
+        die("syntax entry");
+    }
+    entry->syntax = NULL;
+    entry->next = syntax_entries;
+    syntax_entries = entry;
+
+    if (name[0] == '\0' || strchr(name, '/') != NULL){
+        return NULL;
+    }
+    char *dir = expand_path(SYNTAX_DIR);
+    if (dir == NULL){
+        return NULL;
+    }
+    char *path = malloc(strlen(dir) + strlen(name) + 5);
+    if (path == NULL){
+        die("syntax path");
+    }
+    sprintf(path, "%s%s.ini", dir, name);
+    free(dir);
+
+    Ini *ini = parse_ini(path);
+    free(path);
+    if (ini == NULL){
+        return NULL;
+    }
+    entry->syntax = syntax_from_ini(ini, name);
+
+    free(ini->filename);
+    free_table(ini->sections);
+    free(ini);
+    return entry->syntax;
+}
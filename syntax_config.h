@@ -0,0 +1,10 @@
+#ifndef KILO_SYNTAX_CONFIG_H
+#define KILO_SYNTAX_CONFIG_H
+
+#include "editor_config.h"
+
+#define SYNTAX_DIR "~/.kilo/syntax/"
+
+editorSyntax *editorLoadSyntax(const char *name);
+
+#endif
@@ -1,5 +1,10 @@
 #include "text_highlighting.h"
+#include "row.h"
+#include "syntax_config.h"
+#include "byte_scan.h"
 #include "utils.h"
+#include <limits.h>
+#include <pthread.h>
 
 char *C_HL_extensions[] = { ".c", ".h", ".cpp", NULL };
 char *C_HL_keywords[] = {
@@ -11,11 +16,13 @@ char *C_HL_keywords[] = {
 
 struct editorSyntax HLDB[] = {
     {
-        "c",
-        C_HL_extensions,
-        C_HL_keywords,
-        "//", "/*", "*/",
-        HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS
+        .filetype = "c",
+        .filematch = C_HL_extensions,
+        .keywords = C_HL_keywords,
+        .singleline_comment_start = "//",
+        .multiline_comment_start = "/*",
+        .multiline_comment_end = "*/",
+        .flags = HL_HIGHLIGHT_NUMBERS | HL_HIGHLIGHT_STRINGS
     },
 };
 #define HLDB_ENTRIES (sizeof(HLDB) / sizeof(HLDB[0]))
@@ -25,177 +32,602 @@ int is_separator(int c){
 }
 
 void editorUpdateHighlight(editorConfig *config) {
+    (*config).vhl_active = true;
+}
+
+void editorResetHighlight(editorConfig *config){
+    (*config).vhl_active = false;
+}
+
+// resolves the part of the visual selection that falls on filerow as render columns [*start, *end)
+bool editorSelectionInRow(editorConfig *config, int filerow, int *start, int *end){
+    if (!(*config).vhl_active){
+        return false;
+    }
+
     int start_row = (*config).vhl_row <= (*config).cy ? (*config).vhl_row : (*config).cy;
     int end_row = (*config).vhl_row <= (*config).cy ? (*config).cy : (*config).vhl_row;
-
-    int start_idx = (start_row == (*config).cy) ? editor_cx_to_index(config) : (*config).vhl_start;
-    int end_idx = (*config).row[start_row].rsize;
-    if ((*config).cy == (*config).vhl_row){
-        if (editor_cx_to_index(config) > (*config).vhl_start){
-            start_idx = (*config).vhl_start;
-            end_idx = editor_cx_to_index(config);
-        }else{
-            start_idx = editor_cx_to_index(config);
-            end_idx = (*config).vhl_start;
-        }
-        memset(&(*config).row[start_row].vhl[start_idx], VHL_HIGHLIGHT, end_idx - start_idx);
-        return;
+    if (filerow < start_row || filerow > end_row){
+        return false;
     }
 
-    memset(&(*config).row[start_row].vhl[start_idx], VHL_HIGHLIGHT, end_idx - start_idx);
-    for (int y = start_row + 1; y < end_row; y++) {
-        memset((*config).row[y].vhl, VHL_HIGHLIGHT, (*config).row[y].rsize);
+    int cursor_idx = editor_cx_to_index(config);
+    if (start_row == end_row){
+        *start = min(cursor_idx, (*config).vhl_start);
+        *end = max(cursor_idx, (*config).vhl_start);
+        return true;
     }
 
-    end_idx = (end_row == (*config).cy) ? editor_cx_to_index(config): (*config).vhl_start;
-    debug("bef last emeset", "end idx %d cx %d vhl start %d", end_idx, editor_cx_to_index(config), (*config).vhl_start);
-    memset((*config).row[end_row].vhl, VHL_HIGHLIGHT, end_idx);
+    *start = 0;
+    *end = INT_MAX;
+    if (filerow == start_row){
+        *start = (start_row == (*config).cy) ? cursor_idx : (*config).vhl_start;
+    }else if (filerow == end_row){
+        *end = (end_row == (*config).cy) ? cursor_idx : (*config).vhl_start;
+    }
+    return true;
 }
 
-void editorResetHighlight(editorConfig *config){
-    int start_row = (*config).vhl_row <= (*config).cy ? (*config).vhl_row : (*config).cy;
-    int end_row = (*config).vhl_row <= (*config).cy ? (*config).cy : (*config).vhl_row;
+static int editorSyntaxCheckpoint(editorConfig *config, erow *row, int k, int in_comment, hlState *st);
+static int editorHighlightText(struct editorSyntax *syntax, const char *text, int len, int i, int stop, hlState *st, unsigned char *hl);
 
-    int start_idx = (start_row == (*config).cy) ? editor_cx_to_index(config) : (*config).vhl_start;
-    int end_idx = (*config).row[start_row].rsize;
-    if ((*config).cy == (*config).vhl_row){
-        if (editor_cx_to_index(config) > (*config).vhl_start){
-            start_idx = (*config).vhl_start;
-            end_idx = editor_cx_to_index(config);
-        }else{
-            start_idx = editor_cx_to_index(config);
-            end_idx = (*config).vhl_start;
-        }
-        memset(&(*config).row[start_row].vhl[start_idx], VHL_NORMAL, end_idx - start_idx);
-        return;
+// only tracks what carries over to the next row, so it can run on chars without a render.
+// the result is kept with the entry state it came from and survives the render being dropped
+static int editorScanSyntaxState(editorConfig *config, erow *row, int in_comment){
+    if (row->hl_scan_entry == in_comment){
+        return row->hl_open_comment;
+    }
+    row->hl_scan_entry = in_comment;
+    if ((*config).syntax == NULL){
+        row->hl_open_comment = 0;
+        return 0;
     }
 
-    memset(&(*config).row[start_row].vhl[start_idx], VHL_NORMAL, end_idx - start_idx);
-
-    for (int y = start_row + 1; y < end_row; y++) {
-        memset((*config).row[y].vhl, VHL_NORMAL, (*config).row[y].rsize);
+    // long rows finish the scan from their last checkpoint, which later scans reuse
+    if (editorRowIsLong(row)){
+        hlState st;
+        int cx = editorSyntaxCheckpoint(config, row, row->size / ROW_CHECKPOINT_CHARS, in_comment, &st);
+        char buf[ROW_CHECKPOINT_CHARS + ROW_CHECKPOINT_SLACK + 1];
+        int len = editorRowCopyChars(row, cx, row->size - cx, buf);
+        buf[len] = '\0';
+        editorHighlightText((*config).syntax, buf, len, 0, len, &st, NULL);
+        row->hl_open_comment = st.in_comment;
+        return st.in_comment;
     }
 
-    end_idx = (end_row == (*config).cy) ? editor_cx_to_index(config): (*config).vhl_start;
-    memset((*config).row[end_row].vhl, VHL_NORMAL, end_idx);
+    hlState st = {in_comment, 0, 0, 1, 0};
+    editorHighlightText((*config).syntax, editorRowChars(row), row->size, 0, row->size, &st, NULL);
+    row->hl_open_comment = st.in_comment;
+    return st.in_comment;
 }
 
-
-void editorUpdateSyntax(editorConfig *config, erow *row) {
-    row->hl = realloc(row->hl, row->rsize);
-    memset(row->hl, HL_NORMAL, row->rsize);
-
-    if ((*config).syntax == NULL){
+static void editorAdvanceSyntaxFrontier(editorConfig *config, int at){
+    if ((*config).hl_frontier >= at){
         return;
     }
 
-    char **keywords = (*config).syntax->keywords;
+    int last = (*config).hl_scan_last ? rtIndex((*config).hl_scan_last) : -1;
+    erow *row = editorRowAt(config, (*config).hl_frontier);
+    erow *prev = rtPrev(row);
+    int in_comment = prev ? prev->hl_open_comment : 0;
+    while ((*config).hl_frontier < at){
+        in_comment = editorScanSyntaxState(config, row, in_comment);
+        row = rtNext(row);
+        (*config).hl_frontier++;
+
+        // once the state fits what the next row was scanned with, the rows up to hl_scan_last
+        // still chain together and need no walk
+        if (row && row->hl_scan_entry == in_comment && (*config).hl_frontier <= last){
+            erow *end = (last < at) ? (*config).hl_scan_last : editorRowAt(config, at - 1);
+            (*config).hl_frontier = min(last + 1, at);
+            row = rtNext(end);
+            in_comment = end->hl_open_comment;
+        }
+    }
+}
+
+// the rows before the frontier chain their states together; an edit behind the frontier keeps the
+// rows after it chained up to the old frontier, one ahead of it ends the chain before the edited row.
+// rows past the old frontier are left out, an earlier edit may have cut them off from the rows before
+void editorInvalidateSyntax(editorConfig *config, int at){
+    int frontier = (*config).hl_frontier;
+    int last = (*config).hl_scan_last ? rtIndex((*config).hl_scan_last) : -1;
+    if (at < frontier){
+        (*config).hl_scan_last = editorRowAt(config, frontier - 1);
+        (*config).hl_frontier = at;
+    }else if (at > frontier && at <= last){
+        (*config).hl_scan_last = editorRowAt(config, at - 1);
+    }
+    (*config).hl_generation++;
+}
 
-    char *scs = (*config).syntax->singleline_comment_start;
-    char *mcs = (*config).syntax->multiline_comment_start;
-    char *mce = (*config).syntax->multiline_comment_end;
+// runs the highlighter over text[i, stop) starting from *state; delimiters and keywords may look
+// ahead up to len, which need not be NUL terminated. hl may be NULL to only advance the state.
+// returns where scanning stopped, which can be past stop when a token straddles it
+static int editorHighlightText(struct editorSyntax *syntax, const char *text, int len, int i, int stop, hlState *state, unsigned char *hl){
+    // a local copy, since writes through hl could otherwise alias the state
+    hlState st = *state;
+    keywordTable *kw = &syntax->keyword_table;
+    const unsigned char *cls = syntax->byte_class;
+
+    char *scs = syntax->singleline_comment_start;
+    char *mcs = syntax->multiline_comment_start;
+    char *mce = syntax->multiline_comment_end;
     
     int scs_len = (scs) ? strlen(scs) : 0;
     int mcs_len = (mcs) ? strlen(mcs) : 0;
     int mce_len = (mce) ? strlen(mce) : 0;
 
-    int prev_sep = 1;
-    int in_string = 0;
-    int in_comment = (row->idx > 0 && (*config).row[row->idx - 1].hl_open_comment);
-    int i = 0;
+    if (st.in_line_comment){
+        if (hl && i < len){
+            memset(&hl[i], HL_COMMENT, len - i);
+        }
+        *state = st;
+        return max(i, stop);
+    }
 
-    while (i < row->rsize){
-        int c = row->render[i];
-        unsigned char prev_hl = (i > 0) ? row->hl[i - 1] : HL_NORMAL;
+    while (i < stop){
+        int c = (unsigned char)text[i];
+        unsigned char prev_hl = st.prev_number ? HL_NUMBER : HL_NORMAL;
+        st.prev_number = 0;
 
-        if (scs_len && !in_string && !in_comment){
-            if (!strncmp(&row->render[i], scs, scs_len)){
-                memset(&row->hl[i], HL_COMMENT, row->rsize - i);
-                break;
+        if (scs_len && !st.in_string && !st.in_comment && (cls[c] & HL_CLASS_COMMENT)){
+            if (i + scs_len <= len && !memcmp(&text[i], scs, scs_len)){
+                if (hl){
+                    memset(&hl[i], HL_COMMENT, len - i);
+                }
+                st.in_line_comment = 1;
+                *state = st;
+                return stop;
             }
         }
 
-        if (mcs_len && mce_len && !in_string) {
-            if (in_comment) {
-                row->hl[i] = HL_MLCOMMENT;
-                if (!strncmp(&row->render[i], mce, mce_len)) {
-                    memset(&row->hl[i], HL_MLCOMMENT, mce_len);
+        if (mcs_len && mce_len && !st.in_string) {
+            if (st.in_comment) {
+                // the body of the comment up to a possible end is passed over in bulk
+                int skip = bsFindAny(&text[i], stop - i, mce, 1);
+                if (skip){
+                    if (hl){
+                        memset(&hl[i], HL_MLCOMMENT, skip);
+                    }
+                    i += skip;
+                    continue;
+                }
+                if (hl){
+                    hl[i] = HL_MLCOMMENT;
+                }
+                if ((cls[c] & HL_CLASS_MLCOMMENT_END) && i + mce_len <= len && !memcmp(&text[i], mce, mce_len)) {
+                    if (hl){
+                        memset(&hl[i], HL_MLCOMMENT, mce_len);
+                    }
                     i += mce_len;
-                    in_comment = 0;
-                    prev_sep = 1;
+                    st.in_comment = 0;
+                    st.prev_sep = 1;
                     continue;
                 } else {
                     i++;
                     continue;
                 }
-            } else if (!strncmp(&row->render[i], mcs, mcs_len)) {
-                memset(&row->hl[i], HL_MLCOMMENT, mcs_len);
+            } else if ((cls[c] & HL_CLASS_MLCOMMENT) && i + mcs_len <= len && !memcmp(&text[i], mcs, mcs_len)) {
+                if (hl){
+                    memset(&hl[i], HL_MLCOMMENT, mcs_len);
+                }
                 i += mcs_len;
-                in_comment = 1;
+                st.in_comment = 1;
                 continue;
             }
         }
 
-        if ((*config).syntax->flags & HL_HIGHLIGHT_STRINGS){
-            if (in_string){
-                if (c == '\\' && i + 1 < row->rsize) {
-                    row->hl[i + 1] = HL_STRING;
+        if (syntax->flags & HL_HIGHLIGHT_STRINGS){
+            if (st.in_string){
+                char ends[2] = {'\\', st.in_string};
+                int skip = bsFindAny(&text[i], stop - i, ends, 2);
+                if (skip){
+                    if (hl){
+                        memset(&hl[i], HL_STRING, skip);
+                    }
+                    i += skip;
+                    st.prev_sep = 1;
+                    continue;
+                }
+                if (c == '\\' && i + 1 < len) {
+                    if (hl){
+                        hl[i + 1] = HL_STRING;
+                    }
                     i += 2;
                     continue;
                 }
-                row->hl[i] = HL_STRING;
-                if (c == in_string){
-                    in_string = 0;
+                if (hl){
+                    hl[i] = HL_STRING;
+                }
+                if (c == st.in_string){
+                    st.in_string = 0;
                 }
                 i++;
-                prev_sep = 1;
+                st.prev_sep = 1;
                 continue;
             }else{
-                if (c == '"' || c == '\''){
-                    in_string = c;
-                    row->hl[i] = HL_STRING;
+                if (cls[c] & HL_CLASS_STRING){
+                    st.in_string = c;
+                    if (hl){
+                        hl[i] = HL_STRING;
+                    }
                     i++;
                     continue;
                 }
             }
         }
-        if ((*config).syntax->flags & HL_HIGHLIGHT_NUMBERS){
-            if (((isdigit(c)) && (prev_sep || prev_hl == HL_NUMBER)) || ((c == '.') && prev_hl == HL_NUMBER)) {
-                row->hl[i] = HL_NUMBER;
-                prev_sep = 0;
+        if (syntax->flags & HL_HIGHLIGHT_NUMBERS){
+            if (((cls[c] & HL_CLASS_DIGIT) && (st.prev_sep || prev_hl == HL_NUMBER)) || ((c == '.') && prev_hl == HL_NUMBER)) {
+                if (hl){
+                    hl[i] = HL_NUMBER;
+                }
+                st.prev_number = 1;
+                st.prev_sep = 0;
                 i++;
                 continue;
             }
         }
 
-        if (prev_sep) {
-            int j;
-            for (j = 0; keywords[j]; j++) {
-                int klen = strlen(keywords[j]);
-                int kw2 = keywords[j][klen - 1] == '|';
-                if (kw2) {
-                    klen--;
-                }
-                if (!strncmp(&row->render[i], keywords[j], klen) && is_separator(row->render[i + klen])) {
-                    memset(&row->hl[i], kw2 ? HL_KEYWORD2 : HL_KEYWORD1, klen);
-                    i += klen;
-                    break;
-                }
+        // a keyword has to end at a separator, so only the word starting here can match
+        if (st.prev_sep) {
+            int klen = 0;
+            while (klen <= kw->max_len && i + klen < len && !(cls[(unsigned char)text[i + klen]] & HL_CLASS_SEPARATOR)) {
+                klen++;
             }
-            if (keywords[j] != NULL) {
-                prev_sep = 0;
+            int kind = klen ? kwLookup(kw, &text[i], klen) : 0;
+            if (kind) {
+                if (hl){
+                    memset(&hl[i], kind == KW_KIND_SECONDARY ? HL_KEYWORD2 : HL_KEYWORD1, klen);
+                }
+                i += klen;
+                st.prev_sep = 0;
                 continue;
             }
         }
 
-        prev_sep = is_separator(c);
+        st.prev_sep = (cls[c] & HL_CLASS_SEPARATOR) != 0;
         i++;
     }
 
-    int changed = (row->hl_open_comment != in_comment);
-    row->hl_open_comment = in_comment;
-    if (changed && row->idx + 1 < (*config).numrows){
-        editorUpdateSyntax(config, &(*config).row[row->idx + 1]);
+    *state = st;
+    return i;
+}
+
+// state at the k-th checkpoint of a long row, extending the lazily built list as far as needed;
+// returns the chars index the state applies to
+static int editorSyntaxCheckpoint(editorConfig *config, erow *row, int k, int in_comment, hlState *st){
+    if (row->checkpoints_entry != in_comment){
+        row->ncheckpoints = 0;
+    }
+    if (row->checkpoints_cap <= k){
+        row->checkpoints_cap = k + 16;
+        row->checkpoints = realloc(row->checkpoints, sizeof(hlCheckpoint) * row->checkpoints_cap);
+        if (row->checkpoints == NULL){
+            die("syntax checkpoints");
+        }
+    }
+    if (row->ncheckpoints == 0){
+        row->checkpoints[0] = (hlCheckpoint){0, {in_comment, 0, 0, 1, 0}};
+        row->ncheckpoints = 1;
+        row->checkpoints_entry = in_comment;
+    }
+
+    char buf[ROW_CHECKPOINT_CHARS + ROW_CHECKPOINT_SLACK + 1];
+    while (row->ncheckpoints <= k){
+        hlCheckpoint next = row->checkpoints[row->ncheckpoints - 1];
+        int boundary = row->ncheckpoints * ROW_CHECKPOINT_CHARS;
+        if (next.cx < boundary){
+            int len = editorRowCopyChars(row, next.cx, boundary - next.cx + ROW_CHECKPOINT_SLACK, buf);
+            buf[len] = '\0';
+            next.cx += editorHighlightText((*config).syntax, buf, len, 0, min(boundary - next.cx, len), &next.state, NULL);
+        }
+        row->checkpoints[row->ncheckpoints++] = next;
+    }
+
+    *st = row->checkpoints[k].state;
+    return row->checkpoints[k].cx;
+}
+
+static void editorHighlightRow(editorConfig *config, erow *row, int in_comment) {
+    memset(row->hl, HL_NORMAL, row->render_len);
+    row->hl_entry = in_comment;
+
+    if ((*config).syntax == NULL){
+        row->hl_open_comment = 0;
+        row->hl_scan_entry = in_comment;
+        return;
+    }
+
+    hlState st = {in_comment, 0, 0, 1, 0};
+    if (!editorRowIsLong(row)){
+        editorHighlightText((*config).syntax, row->render, row->rsize, 0, row->rsize, &st, row->hl);
+        row->hl_open_comment = st.in_comment;
+        row->hl_scan_entry = in_comment;
+        return;
+    }
+
+    // a long row only highlights its window, resuming from the checkpoint it starts on;
+    // hl_open_comment is left to editorScanSyntaxState
+    int cx = editorSyntaxCheckpoint(config, row, row->render_cx / ROW_CHECKPOINT_CHARS, in_comment, &st);
+    int i = editorRowCxToRx(config, row, cx) - (*config).last_row_digits - row->render_off;
+    editorHighlightText((*config).syntax, row->render, row->render_len, i, row->render_len, &st, row->hl);
+}
+
+void editorUpdateSyntax(editorConfig *config, erow *row){
+    double start = (*config).perf.enabled ? perfNow() : 0;
+    int at = rtIndex(row);
+    editorAdvanceSyntaxFrontier(config, at);
+
+    erow *prev = rtPrev(row);
+    int in_comment = prev ? prev->hl_open_comment : 0;
+    if (row->hl == NULL || row->hl_entry != in_comment){
+        editorHighlightRow(config, row, in_comment);
+    }
+    if ((*config).hl_frontier == at){
+        editorScanSyntaxState(config, row, in_comment);
+        (*config).hl_frontier++;
+    }
+
+    if ((*config).perf.enabled){
+        (*config).perf.syntax_pending_us += perfNow() - start;
+    }
+}
+
+#ifdef KILO_BENCH
+// rescans every row before the frontier from the top; returns the first row whose cached
+// states differ, or -1
+int editorCheckSyntaxStates(editorConfig *config){
+    if ((*config).syntax == NULL){
+        return -1;
+    }
+    int in_comment = 0;
+    erow *row = editorRowAt(config, 0);
+    for (int at = 0; row && at < (*config).hl_frontier; at++, row = rtNext(row)){
+        hlState st = {in_comment, 0, 0, 1, 0};
+        editorHighlightText((*config).syntax, editorRowChars(row), row->size, 0, row->size, &st, NULL);
+        if (row->hl_scan_entry != in_comment || row->hl_open_comment != st.in_comment){
+            return at;
+        }
+        in_comment = st.in_comment;
+    }
+    return -1;
+}
+#endif
+
+/*** background worker ***/
+
+#define HL_WORKER_ROWS 256
+#define HL_WORKER_SKIP 4096
+// checkpoints of a long row scanned in one go; their text and slack fit in the text buffer
+#define HL_WORKER_CHECKPOINTS (ROW_LONG_LINE / ROW_CHECKPOINT_CHARS - 1)
+
+typedef struct hlJob{
+    int at;
+    unsigned int version;
+    int off;
+    int len;
+    int entry;
+    int exit;
+}hlJob;
+
+// the input thread holds lock except while it waits for a key; only then does the worker take rows
+static struct{
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t thread;
+    bool running;
+    bool idle;
+    unsigned int generation;
+    int row;
+    int state;
+    hlJob jobs[HL_WORKER_ROWS];
+    char text[ROW_LONG_LINE + HL_WORKER_ROWS];
+    int long_from;
+    int long_count;
+    hlCheckpoint checkpoints[HL_WORKER_CHECKPOINTS + 1];
+}hl_worker = {.lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER};
+
+// the worker scans on from the frontier, which after a redraw is the end of the viewport,
+// so rows are done nearest to the viewport first. its run is contiguous from there, so it moves
+// the frontier along with it; an edit restarts it at the new frontier
+static bool editorSyntaxWorkPending(editorConfig *config){
+    if ((*config).syntax == NULL){
+        return false;
+    }
+    if (hl_worker.generation != (*config).hl_generation){
+        hl_worker.generation = (*config).hl_generation;
+        hl_worker.row = (*config).hl_frontier;
+        erow *prev = hl_worker.row > 0 ? editorRowAt(config, hl_worker.row - 1) : NULL;
+        hl_worker.state = prev ? prev->hl_open_comment : 0;
+    }
+    return hl_worker.row >= 0 && hl_worker.row < (*config).numrows;
+}
+
+// a long row is taken alone, as the text after its last checkpoint, which the worker extends by
+// HL_WORKER_CHECKPOINTS at a time
+static int editorSyntaxWorkerTakeLong(editorConfig *config, erow *row){
+    hlState st;
+    int k = (row->checkpoints_entry == hl_worker.state) ? max(row->ncheckpoints - 1, 0) : 0;
+    int cx = editorSyntaxCheckpoint(config, row, k, hl_worker.state, &st);
+    hl_worker.long_from = k;
+    hl_worker.long_count = min(HL_WORKER_CHECKPOINTS, row->size / ROW_CHECKPOINT_CHARS - k);
+    hl_worker.checkpoints[0] = (hlCheckpoint){cx, st};
+
+    int end = min((k + hl_worker.long_count) * ROW_CHECKPOINT_CHARS + ROW_CHECKPOINT_SLACK, row->size);
+    int len = editorRowCopyChars(row, cx, end - cx, hl_worker.text);
+    hl_worker.jobs[0] = (hlJob){hl_worker.row, row->hl_version, cx, len, hl_worker.state, 0};
+    return 1;
+}
+
+// copies the text of the next rows whose state is unknown; rows with a fitting cached state are
+// passed over without copying. a long row is scanned from its checkpoints, and once they reach
+// its end its state is taken from the rest of the row
+static int editorSyntaxWorkerTake(editorConfig *config){
+    erow *row = editorRowAt(config, hl_worker.row);
+    for (int skipped = 0; row && row->hl_scan_entry == hl_worker.state && skipped < HL_WORKER_SKIP; skipped++){
+        hl_worker.state = row->hl_open_comment;
+        hl_worker.row++;
+        row = rtNext(row);
+    }
+    (*config).hl_frontier = max((*config).hl_frontier, hl_worker.row);
+
+    int n = 0;
+    int used = 0;
+    hl_worker.long_count = 0;
+    while (row && n < HL_WORKER_ROWS){
+        if (editorRowIsLong(row)){
+            if (n > 0){
+                break;
+            }
+            if (row->checkpoints_entry != hl_worker.state || row->ncheckpoints <= row->size / ROW_CHECKPOINT_CHARS){
+                return editorSyntaxWorkerTakeLong(config, row);
+            }
+            hl_worker.state = editorScanSyntaxState(config, row, hl_worker.state);
+            hl_worker.row++;
+            (*config).hl_frontier = max((*config).hl_frontier, hl_worker.row);
+            row = rtNext(row);
+            continue;
+        }
+        if (used + row->size + 1 > (int)sizeof(hl_worker.text)){
+            break;
+        }
+        hl_worker.jobs[n] = (hlJob){hl_worker.row + n, row->hl_version, used, row->size, 0, 0};
+        used += editorRowCopyChars(row, 0, row->size, &hl_worker.text[used]);
+        hl_worker.text[used++] = '\0';
+        n++;
+        row = rtNext(row);
+    }
+    return n;
+}
+
+static void editorSyntaxWorkerScan(struct editorSyntax *syntax, int n, int state){
+    for (int k = 0; k < n; k++){
+        hlJob *job = &hl_worker.jobs[k];
+        hlState st = {state, 0, 0, 1, 0};
+        editorHighlightText(syntax, &hl_worker.text[job->off], job->len, 0, job->len, &st, NULL);
+        job->entry = state;
+        job->exit = st.in_comment;
+        state = st.in_comment;
+    }
+}
+
+// the same steps as editorSyntaxCheckpoint, on the copied text
+static void editorSyntaxWorkerScanLong(struct editorSyntax *syntax){
+    hlJob *job = &hl_worker.jobs[0];
+    hlCheckpoint next = hl_worker.checkpoints[0];
+    for (int k = 1; k <= hl_worker.long_count; k++){
+        int boundary = (hl_worker.long_from + k) * ROW_CHECKPOINT_CHARS;
+        if (next.cx < boundary){
+            int len = min(boundary - next.cx + ROW_CHECKPOINT_SLACK, job->off + job->len - next.cx);
+            next.cx += editorHighlightText(syntax, &hl_worker.text[next.cx - job->off], len, 0, min(boundary - next.cx, len), &next.state, NULL);
+        }
+        hl_worker.checkpoints[k] = next;
+    }
+}
+
+// the checkpoints only extend a list that is still the one they were scanned from
+static void editorSyntaxWorkerPublishLong(editorConfig *config){
+    hlJob *job = &hl_worker.jobs[0];
+    erow *row = editorRowAt(config, job->at);
+    if (row == NULL || row->hl_version != job->version || row->checkpoints_entry != job->entry ||
+        row->ncheckpoints != hl_worker.long_from + 1){
+        return;
+    }
+    int total = row->ncheckpoints + hl_worker.long_count;
+    if (row->checkpoints_cap < total){
+        row->checkpoints_cap = total + 16;
+        row->checkpoints = realloc(row->checkpoints, sizeof(hlCheckpoint) * row->checkpoints_cap);
+        if (row->checkpoints == NULL){
+            die("syntax checkpoints");
+        }
+    }
+    memcpy(&row->checkpoints[row->ncheckpoints], &hl_worker.checkpoints[1], sizeof(hlCheckpoint) * hl_worker.long_count);
+    row->ncheckpoints = total;
+}
+
+// versions are unique per row content, so a row that was edited or moved by an edit never matches
+static void editorSyntaxWorkerPublish(editorConfig *config, struct editorSyntax *syntax, unsigned int generation, int n){
+    if ((*config).syntax != syntax){
+        return;
+    }
+    int first = -1;
+    for (int k = 0; k < n; k++){
+        hlJob *job = &hl_worker.jobs[k];
+        erow *row = editorRowAt(config, job->at);
+        if (row && row->hl_version == job->version){
+            row->hl_scan_entry = job->entry;
+            row->hl_open_comment = job->exit;
+            first = (first == -1) ? job->at : first;
+        }
+    }
+    if (generation == (*config).hl_generation){
+        hl_worker.row = hl_worker.jobs[n - 1].at + 1;
+        hl_worker.state = hl_worker.jobs[n - 1].exit;
+        (*config).hl_frontier = max((*config).hl_frontier, hl_worker.row);
+    }else if (first != -1 && (*config).hl_scan_last && rtIndex((*config).hl_scan_last) >= first){
+        // after an edit the rows written may no longer chain with the rows that follow them
+        (*config).hl_scan_last = first > 0 ? editorRowAt(config, first - 1) : NULL;
+    }
+}
+
+static void *editorSyntaxWorker(void *arg){
+    editorConfig *config = arg;
+
+    pthread_mutex_lock(&hl_worker.lock);
+    while (1){
+        if (!hl_worker.idle || !editorSyntaxWorkPending(config)){
+            pthread_cond_wait(&hl_worker.wake, &hl_worker.lock);
+            continue;
+        }
+
+        struct editorSyntax *syntax = (*config).syntax;
+        unsigned int generation = (*config).hl_generation;
+        int n = editorSyntaxWorkerTake(config);
+        if (n == 0){
+            continue;
+        }
+        int state = hl_worker.state;
+
+        pthread_mutex_unlock(&hl_worker.lock);
+        if (hl_worker.long_count){
+            editorSyntaxWorkerScanLong(syntax);
+        }else{
+            editorSyntaxWorkerScan(syntax, n, state);
+        }
+        pthread_mutex_lock(&hl_worker.lock);
+
+        if (hl_worker.long_count){
+            if ((*config).syntax == syntax){
+                editorSyntaxWorkerPublishLong(config);
+            }
+        }else{
+            editorSyntaxWorkerPublish(config, syntax, generation, n);
+        }
+    }
+    return NULL;
+}
+
+void editorStartSyntaxWorker(editorConfig *config){
+    pthread_mutex_lock(&hl_worker.lock);
+    hl_worker.generation = (*config).hl_generation - 1;
+    if (pthread_create(&hl_worker.thread, NULL, editorSyntaxWorker, config) == 0){
+        hl_worker.running = true;
+    }
+}
+
+// called around the wait for input: while idle the worker may run
+void editorSyntaxIdle(bool idle){
+    if (!hl_worker.running){
+        return;
+    }
+    if (idle){
+        hl_worker.idle = true;
+        pthread_cond_signal(&hl_worker.wake);
+        pthread_mutex_unlock(&hl_worker.lock);
+    }else{
+        pthread_mutex_lock(&hl_worker.lock);
+        hl_worker.idle = false;
     }
 }
 
@@ -244,30 +676,86 @@ int editorHighlightToColor(int vhl, int *palette, int *index_in_palette){
     }
 }
 
-void editorSelectSyntaxHighlight(editorConfig *config) {
-    (*config).syntax = NULL;
+// turns a definition into the tables the highlighter reads: keyword lookup and a class per byte
+static void editorCompileSyntax(struct editorSyntax *s){
+    kwBuild(&s->keyword_table, s->keywords);
+
+    const char *separators = s->separators ? s->separators : ",.()+-/*=~%<>[];";
+    const char *strings = s->strings ? s->strings : "\"'";
+    for (int c = 0; c < 256; c++){
+        unsigned char cls = 0;
+        if (isspace(c) || c == '\0' || strchr(separators, c) != NULL){
+            cls |= HL_CLASS_SEPARATOR;
+        }
+        if (isdigit(c)){
+            cls |= HL_CLASS_DIGIT;
+        }
+        if ((s->flags & HL_HIGHLIGHT_STRINGS) && c != '\0' && strchr(strings, c) != NULL){
+            cls |= HL_CLASS_STRING;
+        }
+        s->byte_class[c] = cls;
+    }
+    if (s->singleline_comment_start && s->singleline_comment_start[0]){
+        s->byte_class[(unsigned char)s->singleline_comment_start[0]] |= HL_CLASS_COMMENT;
+    }
+    if (s->multiline_comment_start && s->multiline_comment_start[0]){
+        s->byte_class[(unsigned char)s->multiline_comment_start[0]] |= HL_CLASS_MLCOMMENT;
+    }
+    if (s->multiline_comment_end && s->multiline_comment_end[0]){
+        s->byte_class[(unsigned char)s->multiline_comment_end[0]] |= HL_CLASS_MLCOMMENT_END;
+    }
+    s->compiled = true;
+}
+
+// every cached state was computed with the previous syntax
+static void editorResetSyntaxCache(editorConfig *config){
+    (*config).hl_frontier = 0;
+    (*config).hl_scan_last = NULL;
+    (*config).hl_generation++;
+    for (erow *row = editorRowAt(config, 0); row != NULL; row = rtNext(row)) {
+        row->hl_entry = -1;
+        row->hl_scan_entry = -1;
+        row->ncheckpoints = 0;
+    }
+}
+
+// a definition in the syntax directory named after the file's extension (or its name when it has
+// none) takes precedence over the built-in ones
+static struct editorSyntax *editorFindSyntax(editorConfig *config){
     if ((*config).filename == NULL || !(*config).syntax_flag){
-        return;
+        return NULL;
+    }
+
+    char *base = strrchr((*config).filename, '/');
+    base = base ? base + 1 : (*config).filename;
+    char *ext = strrchr(base, '.');
+    struct editorSyntax *s = editorLoadSyntax(ext ? ext + 1 : base);
+    if (s){
+        return s;
     }
 
-    char *ext = strrchr((*config).filename, '.');
     for (unsigned int j = 0; j < HLDB_ENTRIES; j++) {
-        struct editorSyntax *s = &HLDB[j];
+        s = &HLDB[j];
         unsigned int i = 0;
         while (s->filematch[i]) {
             int is_ext = (s->filematch[i][0] == '.');
             if ((is_ext && ext && !strcmp(ext, s->filematch[i])) ||
                 (!is_ext && strstr((*config).filename, s->filematch[i]))) {
-                (*config).syntax = s;
-
-                int filerow;
-                for (filerow = 0; filerow < (*config).numrows; filerow++) {
-                    editorUpdateSyntax(config, &(*config).row[filerow]);
-                }
-                return;
+                return s;
             }
             i++;
         }
     }
+    return NULL;
 }
 
+void editorSelectSyntaxHighlight(editorConfig *config) {
+    struct editorSyntax *prev = (*config).syntax;
+    (*config).syntax = editorFindSyntax(config);
+    if ((*config).syntax && !(*config).syntax->compiled){
+        editorCompileSyntax((*config).syntax);
+    }
+    if ((*config).syntax != prev){
+        editorResetSyntaxCache(config);
+    }
+}
@@ -5,6 +5,14 @@
 #define HL_HIGHLIGHT_NUMBERS (1<<0)
 #define HL_HIGHLIGHT_STRINGS (1<<1)
 
+// per-byte classes compiled from a syntax definition
+#define HL_CLASS_SEPARATOR (1<<0)
+#define HL_CLASS_DIGIT (1<<1)
+#define HL_CLASS_STRING (1<<2)
+#define HL_CLASS_COMMENT (1<<3)
+#define HL_CLASS_MLCOMMENT (1<<4)
+#define HL_CLASS_MLCOMMENT_END (1<<5)
+
 enum editorHighlight {
     HL_NORMAL = 0,
     HL_COMMENT,
@@ -24,12 +32,24 @@ void editorUpdateHighlight(editorConfig *config) ;
 
 void editorResetHighlight(editorConfig *config);
 
+bool editorSelectionInRow(editorConfig *config, int filerow, int *start, int *end);
+
 void editorUpdateSyntax(editorConfig *config, erow *row);
 
+void editorInvalidateSyntax(editorConfig *config, int at);
+
 int editorSyntaxToColor(int hl);
 
 int editorHighlightToColor(int vhl, int *palette, int *index_in_palette);
 
 void editorSelectSyntaxHighlight(editorConfig *config);
 
+void editorStartSyntaxWorker(editorConfig *config);
+
+#ifdef KILO_BENCH
+int editorCheckSyntaxStates(editorConfig *config);
+#endif
+
+void editorSyntaxIdle(bool idle);
+
 #endif
@@ -1,4 +1,5 @@
 #include "utils.h"
+#include <errno.h>
 
 int editor_cx_to_index(editorConfig *config){
     return (*config).cx - (*config).last_row_digits;
@@ -33,6 +34,30 @@ char *tabs_to_spaces(int tabs_count){
     return spaces;
 }
 
+// keeps calling writev until every segment is out; iov is consumed in place
+int writeAll(int fd, struct iovec *iov, int iovcnt){
+    while (iovcnt > 0){
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n == -1){
+            if (errno == EINTR || errno == EAGAIN){
+                continue;
+            }
+            return -1;
+        }
+
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len){
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0){
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return 0;
+}
+
 int count_digits(int num) {
     if (num == 0){
         return 1;
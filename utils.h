@@ -8,6 +8,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <sys/uio.h>
 
 int editor_cx_to_index(editorConfig *config);
 int max(int a, int b);
@@ -16,6 +17,7 @@ int abs(int a);
 char *tabs_to_spaces(int tabs_count);
 int count_digits(int num);
 void die(const char *s);
+int writeAll(int fd, struct iovec *iov, int iovcnt);
 void debug(const char *key, const char *fmt, ...);
 
 #endif